@@ -0,0 +1,127 @@
+#include "MappedFile.hpp"
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename) {
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, 
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    LARGE_INTEGER size{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw std::runtime_error("Failed to get size of file: " + filename);
+    }
+    m_size = static_cast<size_t>(size.QuadPart);
+
+    // Empty files cannot be mapped, they are left as an empty view
+    if (m_size > 0) {
+        m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_mapping) {
+            m_data = static_cast<const uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+    }
+    CloseHandle(file);
+
+    if (m_size > 0 && !m_data) {
+        close();
+        throw std::runtime_error("Failed to map file: " + filename);
+    }
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        UnmapViewOfFile(m_data);
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+    }
+    m_data = nullptr;
+    m_mapping = nullptr;
+    m_size = 0;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename) {
+    const int file = ::open(filename.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw std::runtime_error("Failed to open file: " + filename);
+    }
+
+    struct stat info{};
+    if (::fstat(file, &info) != 0) {
+        ::close(file);
+        throw std::runtime_error("Failed to get size of file: " + filename);
+    }
+    m_size = static_cast<size_t>(info.st_size);
+
+    // Empty files cannot be mapped, they are left as an empty view. 
+    // The mapping stays valid after the descriptor is closed
+    if (m_size > 0) {
+        void* data = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            ::close(file);
+            throw std::runtime_error("Failed to map file: " + filename);
+        }
+        m_data = static_cast<const uint8_t*>(data);
+    }
+    ::close(file);
+}
+
+void MappedFile::close() {
+    if (m_data) {
+        ::munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : m_data(std::exchange(other.m_data, nullptr))
+    , m_size(std::exchange(other.m_size, 0))
+#ifdef _WIN32
+    , m_mapping(std::exchange(other.m_mapping, nullptr))
+#endif
+{}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_data = std::exchange(other.m_data, nullptr);
+        m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+        m_mapping = std::exchange(other.m_mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+const uint8_t* MappedFile::data() const {
+    return m_data;
+}
+
+size_t MappedFile::size() const {
+    return m_size;
+}
@@ -1,11 +1,66 @@
 #include <Parser.hpp>
-#include <fstream>
-#include <sstream>
-#include <nlohmann/json.hpp>
-#include <iostream>
+#include "MappedFile.hpp"
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
 
 using namespace std::string_literals;
 
+namespace {
+
+// Fields are separated the way std::istream separates them, lines end at '\n'
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char* skip_blanks(const char* position, const char* end) {
+    while (position < end && is_blank(*position)) {
+        ++position;
+    }
+    return position;
+}
+
+// Next run of non-blank characters, empty at the end of the line
+std::string_view read_token(const char*& position, const char* end) {
+    const char* begin = skip_blanks(position, end);
+    position = begin;
+    while (position < end && !is_blank(*position)) {
+        ++position;
+    }
+    return {begin, static_cast<size_t>(position - begin)};
+}
+
+// Same result as operator>> of std::istream on well-formed numbers, 
+// which accepts a leading plus that std::from_chars does not
+template <typename T>
+bool read_number(const char*& position, const char* end, T& value) {
+    position = skip_blanks(position, end);
+    const char* begin = position < end && *position == '+' ? position + 1 : position;
+    const auto [next, error] = std::from_chars(begin, end, value);
+    if (error != std::errc{}) {
+        return false;
+    }
+    position = next;
+    return true;
+}
+
+// Leading integer of the text like std::stoi, which throws when there is none
+int read_index(std::string_view text) {
+    const char* begin = text.data() + (text.starts_with('+') ? 1 : 0);
+    int value = 0;
+    const auto [next, error] = std::from_chars(begin, text.data() + text.size(), value);
+    if (error == std::errc::invalid_argument) {
+        throw std::invalid_argument("stoi");
+    }
+    if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range("stoi");
+    }
+    return value;
+}
+
+}
+
 std::unique_ptr<Parser> Parser::create_parser(const std::string& format){
     std::unique_ptr<Parser> parser{};
     if (format == "obj"){
@@ -36,37 +91,44 @@ std::string Parser::get_format(const std::string& path) {
 
 
 void ParserOBJ::parse_file(const std::string& file_path) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) { return; }
+    MappedFile file;
+    try {
+        file = MappedFile(file_path);
+    } catch (const std::runtime_error&) {
+        return;
+    }
 
-    std::string line;
+    const char* position = reinterpret_cast<const char*>(file.data());
+    const char* end = position + file.size();
 
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string type;
-        iss >> type;
+    while (position < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (!line_end) {
+            line_end = end;
+        }
+        const std::string_view type = read_token(position, line_end);
 
         if (type == "v") {
             Point vertex{0, 0, 0, 1};
-            iss >> vertex.x >> vertex.y >> vertex.z;
+            read_number(position, line_end, vertex.x) && read_number(position, line_end, vertex.y) && 
+                read_number(position, line_end, vertex.z);
             m_vertices.push_back(vertex);
         } 
         else if (type == "f") {
             Face face;
             for (int i = 0; i < 3; ++i) {
-                std::string vertex_data;
-                iss >> vertex_data;
-                std::istringstream vertex_stream(vertex_data);
-                std::string vertex_index_str;
-                std::getline(vertex_stream, vertex_index_str, '/');
-                face[i] = std::stoi(vertex_index_str) - 1;
+                const std::string_view vertex_data = read_token(position, line_end);
+                face[i] = read_index(vertex_data.substr(0, vertex_data.find('/'))) - 1;
             }
             m_faces.push_back(face);
         }
         else if (type == "vn") {
             Point normal{0, 0, 0, 1};
-            iss >> normal.x >> normal.y >> normal.z;
+            read_number(position, line_end, normal.x) && read_number(position, line_end, normal.y) && 
+                read_number(position, line_end, normal.z);
             m_normals.push_back(normal);
         }
+
+        position = line_end + 1;
     }
 }
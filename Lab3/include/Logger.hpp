@@ -13,6 +13,7 @@ public:
 
     void set_fps_counter(std::shared_ptr<FPSCounter> counter);
     void set_camera(std::shared_ptr<Camera> camera);
+    void set_render_modes(std::string modes);
     void draw(sf::RenderWindow& window);
     void update();
 
@@ -21,6 +22,7 @@ private:
 
     std::shared_ptr<Camera> m_camera;
     std::shared_ptr<FPSCounter> m_counter;
+    std::string m_modes;
     sf::Text m_text;
     sf::Font m_font;
 };
\ No newline at end of file
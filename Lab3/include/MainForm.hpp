@@ -18,6 +18,8 @@ private:
     void handle_mouse_rotation();
     void handle_keyboard_movement();
     void draw();
+    // Current render modes for the overlay, the keys in on_key_press switch them
+    std::string get_render_modes() const;
     
 private:
     constexpr static double sensitivity{0.1};
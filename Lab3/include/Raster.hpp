@@ -2,14 +2,27 @@
 #include "Matrix.hpp"
 #include "Color.hpp"
 #include "Point.hpp"
+#include "SpecularPower.hpp"
 
 class Raster final{
 public:
+    // How the specular power is evaluated, see SpecularPower::Mode. Off leaves the highlights out
+    enum class SpecularMode {
+        Off,
+        Exact,
+        Table,
+        Squaring
+    };
+
     Raster() noexcept = default;
     ~Raster() = default;
 
     void set_eye(const Vector4& eye);
     void set_sun(const Vector4& sun);
+    void set_specular_mode(SpecularMode mode);
+    SpecularMode get_specular_mode() const;
+    void set_specular_error(double max_error);
+    double get_specular_error() const;
     
     Color::RGBA get_color(const Point& p);
 
@@ -18,10 +31,13 @@ private:
     constexpr static double ka = 0.1;
     constexpr static double kd = 0.9;
     constexpr static double ks = 0.4;
+    constexpr static double specular_error = 1e-3;
     
     constexpr static Color::RGBA ia = Color::Basic::White;
     constexpr static Color::RGBA id = Color::Basic::White;
     constexpr static Color::RGBA is = Color::Basic::White;
 
     Vector4 m_eye, m_sun;
+    SpecularMode m_specular_mode{SpecularMode::Exact};
+    SpecularPower m_specular{a, specular_error};
 };
\ No newline at end of file
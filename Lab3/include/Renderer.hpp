@@ -11,6 +11,11 @@ public:
     ~Renderer() = default;
 
     void set_camera(std::shared_ptr<Camera> camera);
+    void set_specular_mode(Raster::SpecularMode mode);
+    Raster::SpecularMode get_specular_mode() const;
+    // Error bound of the table, and the cutoff of the table and squaring modes
+    void set_specular_error(double max_error);
+    double get_specular_error() const;
     const uint8_t* data() const;
     void clear();
     void draw(Points&& points,
@@ -0,0 +1,33 @@
+#pragma once
+#include <vector>
+
+// Evaluates x^exponent for x in [0, 1], the specular highlight of a material with the given 
+// shininess. Besides std::pow there is a lookup table sized so that its absolute error stays 
+// under max_error, and exponentiation by squaring for integer exponents
+class SpecularPower final {
+public:
+    enum class Mode {
+        Exact,      // std::pow
+        Table,      // Interpolated samples, within max_error
+        Squaring    // Exact for integer exponents, zero where the power is under max_error
+    };
+
+    SpecularPower(double exponent, double max_error) noexcept;
+
+    double evaluate(double x, Mode mode) const;
+    double exact(double x) const;
+    double table(double x) const;
+    double squaring(double x) const;
+
+    double get_exponent() const;
+    double get_max_error() const;
+    int get_table_size() const;
+
+private:
+    double m_exponent;
+    double m_max_error;
+    double m_cutoff;
+    double m_inv_step;
+    int m_integer_exponent;
+    std::vector<double> m_table;
+};
@@ -20,6 +20,10 @@ void Logger::set_camera(std::shared_ptr<Camera> camera) {
     m_camera = std::move(camera);
 }
 
+void Logger::set_render_modes(std::string modes) {
+    m_modes = std::move(modes);
+}
+
 void Logger::draw(sf::RenderWindow& window) {
     window.draw(m_text);
 }
@@ -36,12 +40,14 @@ void Logger::update() {
         "Eye = [{:.2f}, {:.2f}, {:.2f}]\n"
         "target = [{:.2f}, {:.2f}, {:.2f}]\n"
         "up = [{:.2f}, {:.2f}, {:.2f}]\n"
-        "Scale = {:.2f}",
+        "Scale = {:.2f}\n"
+        "{}",
         fps, 
         eye.x, eye.y, eye.z,
         target.x, target.y, target.z,
         up.x, up.y, up.z,
-        scale
+        scale,
+        m_modes
     );
 
     m_text.setString(text_str);
@@ -6,6 +6,28 @@
 
 using namespace std::string_literals;
 
+namespace {
+
+using SpecularMode = Raster::SpecularMode;
+
+// The brackets divide or multiply the error bound of the specular power by the step
+constexpr double MIN_SPECULAR_ERROR{1e-6};
+constexpr double MAX_SPECULAR_ERROR{1e-1};
+constexpr double SPECULAR_ERROR_STEP{10.0};
+
+constexpr std::array<std::pair<SpecularMode, const char*>, 4> SPECULAR_MODES = {{
+    {SpecularMode::Off,      "off"},
+    {SpecularMode::Exact,    "exact"},
+    {SpecularMode::Table,    "table"},
+    {SpecularMode::Squaring, "squaring"}
+}};
+
+size_t find_specular_mode(SpecularMode mode) {
+    return std::ranges::find(SPECULAR_MODES, mode, &std::pair<SpecularMode, const char*>::first) - SPECULAR_MODES.begin();
+}
+
+}
+
 MainForm::MainForm() noexcept
     : m_window(sf::VideoMode(width, height), "Lab 3")
     , m_camera(std::make_shared<Camera>())
@@ -86,6 +108,7 @@ void MainForm::draw() {
     m_window.display();
     
     m_counter->update();
+    m_logger.set_render_modes(get_render_modes());
     m_logger.update();
 }
 
@@ -164,5 +187,27 @@ void MainForm::on_key_press(sf::Keyboard::Key code) {
         case sf::Keyboard::Q:
             m_window.close();
             break;
+
+        case sf::Keyboard::P: {
+            const size_t current = find_specular_mode(m_renderer.get_specular_mode());
+            m_renderer.set_specular_mode(SPECULAR_MODES[(current + 1) % SPECULAR_MODES.size()].first);
+            m_needs_update = true;
+            break;
+        }
+
+        case sf::Keyboard::LBracket:
+        case sf::Keyboard::RBracket: {
+            const double step = code == sf::Keyboard::LBracket ? 1.0 / SPECULAR_ERROR_STEP : SPECULAR_ERROR_STEP;
+            m_renderer.set_specular_error(std::clamp(m_renderer.get_specular_error() * step, 
+                                                     MIN_SPECULAR_ERROR, MAX_SPECULAR_ERROR));
+            m_needs_update = true;
+            break;
+        }
     }
 }
+
+std::string MainForm::get_render_modes() const {
+    return std::format("Specular = {}, error = {:.0e}", 
+                       SPECULAR_MODES[find_specular_mode(m_renderer.get_specular_mode())].second,
+                       m_renderer.get_specular_error());
+}
@@ -10,6 +10,22 @@ void Raster::set_sun(const Vector4& sun){
     m_sun = sun;
 }
 
+void Raster::set_specular_mode(SpecularMode mode) {
+    m_specular_mode = mode;
+}
+
+Raster::SpecularMode Raster::get_specular_mode() const {
+    return m_specular_mode;
+}
+
+void Raster::set_specular_error(double max_error) {
+    m_specular = SpecularPower(a, max_error);
+}
+
+double Raster::get_specular_error() const {
+    return m_specular.get_max_error();
+}
+
 Color::RGBA Raster::get_color(const Point& point) {
     const auto& [world, screen, normal] = point;
     
@@ -26,9 +42,17 @@ Color::RGBA Raster::get_color(const Point& point) {
     }
     double diffuse_coef = kd * NL;
     Color::RGBA Id = Color::multiply(id, diffuse_coef);
+
+    if (m_specular_mode == SpecularMode::Off) {
+        return Color::add(Ia, Id);
+    }
     
     Vector4 R = ((N * (2.0 * NL)) - L).normalize();
-    double specular_coef = ks * std::pow(std::max(0.0, R.dot(V)), a);
+    const double RV = std::max(0.0, R.dot(V));
+    const auto power_mode = m_specular_mode == SpecularMode::Table ? SpecularPower::Mode::Table
+        : m_specular_mode == SpecularMode::Squaring ? SpecularPower::Mode::Squaring
+        : SpecularPower::Mode::Exact;
+    double specular_coef = ks * m_specular.evaluate(RV, power_mode);
     Color::RGBA Is = Color::multiply(is, specular_coef);
     
     return Color::add(Ia, Id, Is);
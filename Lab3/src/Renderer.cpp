@@ -20,6 +20,22 @@ void Renderer::set_camera(std::shared_ptr<Camera> camera){
     m_camera = camera;
 }
 
+void Renderer::set_specular_mode(Raster::SpecularMode mode){
+    m_raster.set_specular_mode(mode);
+}
+
+Raster::SpecularMode Renderer::get_specular_mode() const {
+    return m_raster.get_specular_mode();
+}
+
+void Renderer::set_specular_error(double max_error) {
+    m_raster.set_specular_error(max_error);
+}
+
+double Renderer::get_specular_error() const {
+    return m_raster.get_specular_error();
+}
+
 void Renderer::draw_triangle(Point p1, Point p2, Point p3) {
     auto& [w1, s1, n1] = p1;
     auto& [w2, s2, n2] = p2;
@@ -0,0 +1,91 @@
+#include "SpecularPower.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int MIN_TABLE_SIZE{2};
+constexpr int MAX_TABLE_SIZE{1 << 16};
+constexpr double MIN_ERROR{1e-7};
+
+}
+
+SpecularPower::SpecularPower(double exponent, double max_error) noexcept
+    : m_exponent(exponent)
+    , m_max_error(std::max(max_error, MIN_ERROR))
+{
+    // Below the cutoff x^exponent is under max_error, so it is treated as zero
+    m_cutoff = std::pow(m_max_error, 1.0 / exponent);
+
+    // Linear interpolation between samples h apart is off by at most h^2 / 8 * max|f''|, 
+    // half of the error budget is left for the rounding of the samples themselves
+    const double a = exponent;
+    const double max_second_derivative = a * std::abs(a - 1) * std::max(std::pow(m_cutoff, a - 2), 1.0);
+    const double step = max_second_derivative > 0 
+        ? std::sqrt(4.0 * m_max_error / max_second_derivative) 
+        : 1.0;
+
+    const int size = static_cast<int>(std::ceil((1.0 - m_cutoff) / step)) + 1;
+    m_table.resize(std::clamp(size, MIN_TABLE_SIZE, MAX_TABLE_SIZE));
+    m_inv_step = (m_table.size() - 1) / (1.0 - m_cutoff);
+
+    for (int i = 0; i < static_cast<int>(m_table.size()); ++i) {
+        const double x = m_cutoff + (1.0 - m_cutoff) * i / (m_table.size() - 1);
+        m_table[i] = std::pow(x, a);
+    }
+
+    const double integer_part = std::round(exponent);
+    m_integer_exponent = integer_part == exponent && exponent >= 0 ? static_cast<int>(integer_part) : -1;
+}
+
+double SpecularPower::evaluate(double x, Mode mode) const {
+    switch (mode) {
+        case Mode::Table: return table(x);
+        case Mode::Squaring: return squaring(x);
+        default: return exact(x);
+    }
+}
+
+double SpecularPower::exact(double x) const {
+    return std::pow(x, m_exponent);
+}
+
+double SpecularPower::table(double x) const {
+    if (x <= m_cutoff) return 0.0;
+    if (x >= 1.0) return 1.0;
+
+    const double position = (x - m_cutoff) * m_inv_step;
+    const int index = std::min(static_cast<int>(position), static_cast<int>(m_table.size()) - 2);
+    const double t = position - index;
+    return m_table[index] + (m_table[index + 1] - m_table[index]) * t;
+}
+
+// Exponentiation by squaring, not an approximation: the power of an integer exponent up to 
+// rounding in a handful of multiplications for the usual shininess values. Exponents that 
+// are not integer go through the table instead
+double SpecularPower::squaring(double x) const {
+    if (m_integer_exponent < 0) return table(x);
+    if (x <= m_cutoff) return 0.0;
+
+    double result = 1.0;
+    double base = x;
+    for (int exponent = m_integer_exponent; exponent != 0; exponent >>= 1) {
+        if (exponent & 1) {
+            result *= base;
+        }
+        base *= base;
+    }
+    return result;
+}
+
+double SpecularPower::get_exponent() const {
+    return m_exponent;
+}
+
+double SpecularPower::get_max_error() const {
+    return m_max_error;
+}
+
+int SpecularPower::get_table_size() const {
+    return static_cast<int>(m_table.size());
+}
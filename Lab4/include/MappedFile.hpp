@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Read-only view of a whole file mapped into memory. Pages are read in by the OS on the 
+// first access, so parts of the file that are never touched take no memory
+class MappedFile final {
+public:
+    MappedFile() noexcept = default;
+
+    // Throws std::runtime_error when the file cannot be opened or mapped
+    explicit MappedFile(const std::string& filename);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const;
+    size_t size() const;
+
+private:
+    void close();
+
+    const uint8_t* m_data{};
+    size_t m_size{};
+#ifdef _WIN32
+    void* m_mapping{};
+#endif
+};
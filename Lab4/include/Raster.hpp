@@ -6,6 +6,11 @@
 
 class Raster final{
 public:
+    // Unit normal stored as three signed normalized bytes
+    struct PackedNormal {
+        int8_t x, y, z;
+    };
+
     Raster() noexcept;
     ~Raster() = default;
 
@@ -29,7 +34,7 @@ private:
     const std::string specular_path = "../model/specular.raw";
 
     std::vector<std::vector<uint32_t>> arr_diffuse;
-    std::vector<std::vector<uint32_t>> arr_normal;
+    std::vector<std::vector<PackedNormal>> arr_normal;
     std::vector<std::vector<uint32_t>> arr_specular;
 
     glm::vec3 m_eye, m_sun;
@@ -1,10 +1,85 @@
 #include <Parser.hpp>
-#include <fstream>
-#include <sstream>
-#include <nlohmann/json.hpp>
+#include "MappedFile.hpp"
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
 
 using namespace std::string_literals;
 
+namespace {
+
+// Fields are separated the way std::istream separates them, lines end at '\n'
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char* skip_blanks(const char* position, const char* end) {
+    while (position < end && is_blank(*position)) {
+        ++position;
+    }
+    return position;
+}
+
+// Next run of non-blank characters, empty at the end of the line
+std::string_view read_token(const char*& position, const char* end) {
+    const char* begin = skip_blanks(position, end);
+    position = begin;
+    while (position < end && !is_blank(*position)) {
+        ++position;
+    }
+    return {begin, static_cast<size_t>(position - begin)};
+}
+
+// Same result as operator>> of std::istream on well-formed numbers, 
+// which accepts a leading plus that std::from_chars does not
+template <typename T>
+bool read_number(const char*& position, const char* end, T& value) {
+    position = skip_blanks(position, end);
+    const char* begin = position < end && *position == '+' ? position + 1 : position;
+    const auto [next, error] = std::from_chars(begin, end, value);
+    if (error != std::errc{}) {
+        return false;
+    }
+    position = next;
+    return true;
+}
+
+// Leading integer of the text like std::stoi, which throws when there is none
+int read_index(std::string_view text) {
+    const char* begin = text.data() + (text.starts_with('+') ? 1 : 0);
+    int value = 0;
+    const auto [next, error] = std::from_chars(begin, text.data() + text.size(), value);
+    if (error == std::errc::invalid_argument) {
+        throw std::invalid_argument("stoi");
+    }
+    if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range("stoi");
+    }
+    return value;
+}
+
+// Position, texture and normal indices of a v/vt/vn group made zero based, 
+// missing ones become -1
+std::array<uint32_t, 3> read_face_vertex(std::string_view vertex_data) {
+    std::array<uint32_t, 3> indices{};
+    for (uint32_t& index : indices) {
+        const size_t slash = vertex_data.find('/');
+        const std::string_view part = vertex_data.substr(0, slash);
+        const uint32_t value = part.empty() ? 0 : static_cast<uint32_t>(read_index(part));
+        index = value != 0 ? value - 1 : static_cast<uint32_t>(-1);
+
+        if (slash == std::string_view::npos) {
+            vertex_data = {};
+        } else {
+            vertex_data.remove_prefix(slash + 1);
+        }
+    }
+    return indices;
+}
+
+}
+
 std::unique_ptr<Parser> Parser::create_parser(const std::string& format){
     std::unique_ptr<Parser> parser{};
     if (format == "obj"){
@@ -39,73 +114,59 @@ std::string Parser::get_format(const std::string& path) {
 
 
 void ParserOBJ::parse_file(const std::string& file_path) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) { return; }
+    MappedFile file;
+    try {
+        file = MappedFile(file_path);
+    } catch (const std::runtime_error&) {
+        return;
+    }
 
-    std::string line;
+    const char* position = reinterpret_cast<const char*>(file.data());
+    const char* end = position + file.size();
 
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string type;
-        iss >> type;
+    while (position < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (!line_end) {
+            line_end = end;
+        }
+        const std::string_view type = read_token(position, line_end);
 
         if (type == "v") {
             glm::vec4 vertex{0, 0, 0, 1};
-            iss >> vertex.x >> vertex.y >> vertex.z;
+            read_number(position, line_end, vertex.x) && read_number(position, line_end, vertex.y) && 
+                read_number(position, line_end, vertex.z);
             m_vertices.push_back(vertex);
         } 
         else if (type == "f") {
-            std::vector<std::array<uint32_t, 3>> face_vertices;
-            std::string vertex_data;
-            
-            while (iss >> vertex_data) {
-                std::vector<std::string> parts;
-                size_t start = 0;
-                size_t end = vertex_data.find('/');
-                
-                while (true) {
-                    parts.push_back(vertex_data.substr(start, end - start));
-                    if (end == std::string::npos) break;
-                    start = end + 1;
-                    end = vertex_data.find('/', start);
+            // Polygons are split into a fan around the first vertex
+            std::array<uint32_t, 3> first{};
+            std::array<uint32_t, 3> previous{};
+            int count = 0;
+            for (auto vertex_data = read_token(position, line_end); !vertex_data.empty(); 
+                 vertex_data = read_token(position, line_end)) 
+            {
+                const std::array<uint32_t, 3> current = read_face_vertex(vertex_data);
+                if (count == 0) {
+                    first = current;
+                } else if (count >= 2) {
+                    m_faces.push_back(Face{first, previous, current});
                 }
-
-                int v = 0, vt = 0, vn = 0;
-
-                if (!parts[0].empty())
-                    v = std::stoi(parts[0]);
-                if (parts.size() > 1 && !parts[1].empty())
-                    vt = std::stoi(parts[1]);
-                if (parts.size() > 2 && !parts[2].empty())
-                    vn = std::stoi(parts[2]);
-
-                v = (v != 0) ? v - 1 : -1;
-                vt = (vt != 0) ? vt - 1 : -1;
-                vn = (vn != 0) ? vn - 1 : -1;
-
-                face_vertices.push_back({v, vt, vn});
-            }
-
-            size_t num_verts = face_vertices.size();
-            if (num_verts < 3) continue;
-
-            for (size_t i = 1; i < num_verts - 1; ++i) {
-                Face face;
-                face[0] = face_vertices[0];
-                face[1] = face_vertices[i];
-                face[2] = face_vertices[i + 1];
-                m_faces.push_back(face);
+                previous = current;
+                count++;
             }
         }
         else if (type == "vn") {
             glm::vec3 normal{0, 0, 0};
-            iss >> normal.x >> normal.y >> normal.z;
+            read_number(position, line_end, normal.x) && read_number(position, line_end, normal.y) && 
+                read_number(position, line_end, normal.z);
             m_normals.push_back(normal);
         }
         else if (type == "vt") {
             glm::vec3 texture_vertex{0, 0, 0};
-            iss >> texture_vertex.x >> texture_vertex.y;
+            read_number(position, line_end, texture_vertex.x) && read_number(position, line_end, texture_vertex.y);
             m_texture_vertices.push_back(texture_vertex);
         }
+
+        position = line_end + 1;
     }
 }
@@ -1,6 +1,6 @@
 #include "Raster.hpp"
+#include "MappedFile.hpp"
 #include <cmath>
-#include <fstream>
 #include <iostream>
 #include <stdexcept>
 #include <iostream>
@@ -9,27 +9,24 @@ namespace {
 
 constexpr static int WIDTH = 2048;
 constexpr static int HEIGHT = 2048;
+constexpr static float SNORM8_MAX = 127.0f;
 
+// The file is mapped and converted row by row straight from the mapping
 std::vector<std::vector<uint32_t>> load_texture(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Failed to open texture file: " + filename);
+    const MappedFile file(filename);
+    if (file.size() < static_cast<size_t>(WIDTH) * HEIGHT * 3) {
+        throw std::runtime_error("Unexpected end of file in texture: " + filename);
     }
 
     std::vector<std::vector<uint32_t>> texture(HEIGHT, std::vector<uint32_t>(WIDTH));
-    std::vector<uint8_t> row_buffer(WIDTH * 3);
 
     for (int y = 0; y < HEIGHT; ++y) {
-        file.read(reinterpret_cast<char*>(row_buffer.data()), WIDTH * 3);
-        
-        if (file.gcount() != WIDTH * 3) {
-            throw std::runtime_error("Unexpected end of file in texture: " + filename);
-        }
+        const uint8_t* row = file.data() + static_cast<size_t>(y) * WIDTH * 3;
 
         for (int x = 0; x < WIDTH; ++x) {
-            uint8_t r = row_buffer[x*3];
-            uint8_t g = row_buffer[x*3 + 1];
-            uint8_t b = row_buffer[x*3 + 2];
+            uint8_t r = row[x*3];
+            uint8_t g = row[x*3 + 1];
+            uint8_t b = row[x*3 + 2];
             texture[y][x] = (0xFF << 24) | (b << 16) | (g << 8) | r;
         }
     }
@@ -49,14 +46,40 @@ glm::vec3 normal_from_color(uint32_t color) {
     });
 }
 
-Color::RGBA getPixel(const std::vector<std::vector<uint32_t>>& data, float u, float v) {
+int8_t to_snorm8(float value) {
+    return static_cast<int8_t>(std::lround(std::clamp(value, -1.0f, 1.0f) * SNORM8_MAX));
+}
+
+// The normal map is static, so it is remapped and normalized once at load 
+// instead of on every fetch, a fetch is then three conversions and a scale
+std::vector<std::vector<Raster::PackedNormal>> decode_normal_map(const std::vector<std::vector<uint32_t>>& texture) {
+    std::vector<std::vector<Raster::PackedNormal>> normals(HEIGHT, std::vector<Raster::PackedNormal>(WIDTH));
+    for (int y = 0; y < HEIGHT; ++y) {
+        std::ranges::transform(texture[y], normals[y].begin(), [](uint32_t color) {
+            const glm::vec3 normal = normal_from_color(color);
+            return Raster::PackedNormal{to_snorm8(normal.x), to_snorm8(normal.y), to_snorm8(normal.z)};
+        });
+    }
+    return normals;
+}
+
+glm::vec3 unpack_normal(Raster::PackedNormal normal) {
+    return glm::vec3{
+        static_cast<float>(normal.x), 
+        static_cast<float>(normal.y), 
+        static_cast<float>(normal.z)
+    } * (1.0f / SNORM8_MAX);
+}
+
+template<typename T>
+T getPixel(const std::vector<std::vector<T>>& data, float u, float v) {
     u = std::clamp(u, 0.0f, 1.0f);
     v = 1.0f - std::clamp(v, 0.0f, 1.0f);
     
     int x = std::clamp((int)(u * WIDTH), 0, WIDTH - 1);
     int y = std::clamp((int)(v * HEIGHT), 0, HEIGHT - 1);
     
-    return static_cast<Color::RGBA>(data[y][x]);
+    return data[y][x];
 }
 
 }
@@ -64,14 +87,14 @@ Color::RGBA getPixel(const std::vector<std::vector<uint32_t>>& data, float u, fl
 Raster::Raster() noexcept {
     try {
         arr_diffuse = load_texture(diffuse_path);
-        arr_normal = load_texture(normal_path);
+        arr_normal = decode_normal_map(load_texture(normal_path));
         arr_specular = load_texture(specular_path);
         //arr_normal = std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0));
         //arr_specular = std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0));
     } catch (const std::exception& e) {
         std::cerr << "Texture loading error: " << e.what() << std::endl;
         arr_diffuse = std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0));
-        arr_normal = std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0));
+        arr_normal = decode_normal_map(std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0)));
         arr_specular = std::vector<std::vector<uint32_t>>(HEIGHT, std::vector<uint32_t>(WIDTH, 0));
     }
 }
@@ -89,7 +112,7 @@ Color::RGBA Raster::get_color(const Point& point) {
     
     Color::RGBA DColor = getPixel(arr_diffuse, texture.x, texture.y); 
     
-    glm::vec3 tex_normal = normal_from_color(getPixel(arr_normal, texture.x, texture.y));
+    glm::vec3 tex_normal = unpack_normal(getPixel(arr_normal, texture.x, texture.y));
     //glm::vec3 tex_normal = normal;
     
     glm::vec3 N = glm::normalize(normal + tex_normal);
@@ -0,0 +1,82 @@
+#include "Parser.hpp"
+#include "TempFile.hpp"
+#include <benchmark/benchmark.h>
+#include <format>
+
+namespace {
+
+// OBJ text of a UV sphere with the layout of the exported models: 
+// positions, normals and texture coordinates followed by faces
+std::string create_sphere(int segments) {
+    std::string text;
+    for (int i = 0; i <= segments; ++i) {
+        const float theta = PI * i / segments;
+        for (int j = 0; j < segments; ++j) {
+            const float phi = TWO_PI * j / segments;
+            const float x = std::sin(theta) * std::cos(phi);
+            const float y = std::cos(theta);
+            const float z = std::sin(theta) * std::sin(phi);
+            text += std::format("v {:.6f} {:.6f} {:.6f}\n", x, y, z);
+            text += std::format("vn {:.6f} {:.6f} {:.6f}\n", x, y, z);
+            text += std::format("vt {:.6f} {:.6f}\n", static_cast<float>(j) / segments, static_cast<float>(i) / segments);
+        }
+    }
+
+    text += "usemtl body\n";
+    for (int i = 0; i < segments; ++i) {
+        for (int j = 0; j < segments; ++j) {
+            const int a = i * segments + j + 1;
+            const int b = i * segments + (j + 1) % segments + 1;
+            const int c = a + segments;
+            const int d = b + segments;
+            text += std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, b, d);
+            text += std::format("f {0}/{0}/{0} {1}/{1}/{1} {2}/{2}/{2}\n", a, d, c);
+        }
+    }
+    return text;
+}
+
+void BM_ParseObj(benchmark::State& state) {
+    const int segments = static_cast<int>(state.range(0));
+    const TempFile file(std::format("akg_bench_{}.obj", segments), create_sphere(segments));
+    ParserOBJ parser;
+    parser.set_threads_count(static_cast<int>(state.range(1)));
+    parser.set_cache_enabled(false);
+
+    for (auto _ : state) {
+        parser.parse_file(file.get_path());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(file.get_size()));
+    state.counters["faces"] = static_cast<double>(parser.get_faces().size());
+}
+
+// Later parses of an unchanged file, which read the mesh cache written by the first one
+void BM_LoadObjCache(benchmark::State& state) {
+    const int segments = static_cast<int>(state.range(0));
+    const TempFile file(std::format("akg_bench_cached_{}.obj", segments), create_sphere(segments));
+    ParserOBJ parser;
+    parser.parse_file(file.get_path());
+
+    for (auto _ : state) {
+        parser.parse_file(file.get_path());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(file.get_size()));
+    state.counters["faces"] = static_cast<double>(parser.get_faces().size());
+
+    std::error_code error;
+    std::filesystem::remove(file.get_path() + ".mesh", error);
+}
+
+}
+
+// Files of the larger spheres are split into chunks parsed in parallel
+BENCHMARK(BM_ParseObj)
+    ->ArgNames({"segments", "threads"})
+    ->ArgsProduct({{64, 256, 512}, {1, 4}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+BENCHMARK(BM_LoadObjCache)->ArgName("segments")->Arg(64)->Arg(256)->Arg(512)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,233 @@
+#include "Raster.hpp"
+#include "TempFile.hpp"
+#include <benchmark/benchmark.h>
+#include <random>
+
+namespace {
+
+constexpr int FRAGMENTS_COUNT{4096};
+constexpr unsigned SEED{42};
+
+struct Fragments {
+    Vertices world;
+    Vertices normals;
+    TextureVertices texture;
+};
+
+// Points of a unit sphere seen from the default camera position
+Fragments create_fragments() {
+    std::mt19937 generator(SEED);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+
+    Fragments fragments;
+    for (int i = 0; i < FRAGMENTS_COUNT; ++i) {
+        const glm::vec3 normal = glm::normalize(glm::vec3{
+            distribution(generator), distribution(generator), distribution(generator)});
+        fragments.world.push_back(normal);
+        fragments.normals.push_back(normal);
+        fragments.texture.push_back({
+            (distribution(generator) + 1) / 2, (distribution(generator) + 1) / 2});
+    }
+    return fragments;
+}
+
+void BM_ShadeFragments(benchmark::State& state) {
+    static Raster raster;
+    raster.wait_for_textures();
+    raster.set_eye({0, 0, 5});
+    raster.set_sun({0, 0, 5});
+    raster.set_specular_mode(static_cast<Raster::SpecularMode>(state.range(0)));
+
+    const Fragments fragments = create_fragments();
+
+    for (auto _ : state) {
+        for (int i = 0; i < FRAGMENTS_COUNT; ++i) {
+            const Raster::PointData point{fragments.world[i], fragments.normals[i], fragments.texture[i]};
+            benchmark::DoNotOptimize(raster.get_color(point, i % raster.get_materials_count(), 0.0f));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * FRAGMENTS_COUNT);
+    state.counters["pixels"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * FRAGMENTS_COUNT, benchmark::Counter::kIsRate);
+}
+
+void BM_ShadeFragmentBatches(benchmark::State& state) {
+    static Raster raster;
+    raster.wait_for_textures();
+    raster.set_eye({0, 0, 5});
+    raster.set_sun({0, 0, 5});
+    raster.set_specular_mode(static_cast<Raster::SpecularMode>(state.range(0)));
+
+    const Fragments fragments = create_fragments();
+    std::vector<Raster::FragmentBatch> batches(FRAGMENTS_COUNT / Raster::BATCH_SIZE);
+    for (int i = 0; i < FRAGMENTS_COUNT; ++i) {
+        auto& batch = batches[i / Raster::BATCH_SIZE];
+        const int lane = i % Raster::BATCH_SIZE;
+        batch.world_x[lane] = fragments.world[i].x;
+        batch.world_y[lane] = fragments.world[i].y;
+        batch.world_z[lane] = fragments.world[i].z;
+        batch.normal_x[lane] = fragments.normals[i].x;
+        batch.normal_y[lane] = fragments.normals[i].y;
+        batch.normal_z[lane] = fragments.normals[i].z;
+        batch.u[lane] = fragments.texture[i].x;
+        batch.v[lane] = fragments.texture[i].y;
+    }
+
+    Color::RGBA colors[Raster::BATCH_SIZE];
+    for (auto _ : state) {
+        for (int i = 0; i < static_cast<int>(batches.size()); ++i) {
+            raster.get_colors(batches[i], Raster::FULL_BATCH, i % raster.get_materials_count(), 0.0f, colors);
+            benchmark::DoNotOptimize(colors);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * FRAGMENTS_COUNT);
+    state.counters["pixels"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * FRAGMENTS_COUNT, benchmark::Counter::kIsRate);
+}
+
+constexpr int SAMPLE_TILE_SIZE{64};
+
+// Visits a screen_size square the way tiles of the renderer do, in 64x64 pixel blocks
+template<typename F>
+void for_each_tile_pixel(int screen_size, F&& f) {
+    for (int tile_y = 0; tile_y < screen_size; tile_y += SAMPLE_TILE_SIZE) {
+        for (int tile_x = 0; tile_x < screen_size; tile_x += SAMPLE_TILE_SIZE) {
+            for (int y = tile_y; y < tile_y + SAMPLE_TILE_SIZE; ++y) {
+                for (int x = tile_x; x < tile_x + SAMPLE_TILE_SIZE; ++x) {
+                    f(x, y);
+                }
+            }
+        }
+    }
+}
+
+Texture2D create_pattern(Texture2D::Layout layout) {
+    Texture2D texture(Raster::TEXTURE_WIDTH, Raster::TEXTURE_HEIGHT, layout);
+    for (int y = 0; y < Raster::TEXTURE_HEIGHT; ++y) {
+        for (int x = 0; x < Raster::TEXTURE_WIDTH; ++x) {
+            texture.set(x, y, static_cast<uint32_t>(x ^ y));
+        }
+    }
+    return texture;
+}
+
+// Full level point sampled across the screen rotated by the angle and scaled by the 
+// given texels per pixel
+void BM_SampleTexture(benchmark::State& state) {
+    const auto layout = static_cast<Texture2D::Layout>(state.range(0));
+    const float angle = static_cast<float>(state.range(1)) * PI / 180.0f;
+    const int scale = static_cast<int>(state.range(2));
+    const int size = Raster::TEXTURE_WIDTH;
+    const int screen_size = std::max(size / scale, SAMPLE_TILE_SIZE);
+
+    const Texture2D texture = create_pattern(layout);
+    const float cos = std::cos(angle) * scale;
+    const float sin = std::sin(angle) * scale;
+    uint32_t sum = 0;
+    for (auto _ : state) {
+        for_each_tile_pixel(screen_size, [&](int x, int y) {
+            const int u = static_cast<int>(x * cos - y * sin) & (size - 1);
+            const int v = static_cast<int>(x * sin + y * cos) & (size - 1);
+            sum += texture.get(u, v);
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * screen_size * screen_size);
+}
+
+// The same walk through the mip chain with the level of detail of the scale, 
+// optionally BC1 compressed
+void BM_SampleMipChain(benchmark::State& state) {
+    const auto filter = static_cast<MipChain::Filter>(state.range(0));
+    const int scale = static_cast<int>(state.range(1));
+    const int screen_size = std::max(Raster::TEXTURE_WIDTH / scale, SAMPLE_TILE_SIZE);
+
+    ThreadPool pool(1);
+    MipChain chain(create_pattern(Raster::TEXTURE_LAYOUT), pool);
+    if (state.range(2)) {
+        chain.compress(BlockTexture::Format::BC1);
+    }
+    const float lod = std::log2(static_cast<float>(scale));
+    const float step = static_cast<float>(scale) / Raster::TEXTURE_WIDTH;
+    uint32_t sum = 0;
+    for (auto _ : state) {
+        for_each_tile_pixel(screen_size, [&](int x, int y) {
+            sum += chain.sample(x * step, y * step, lod, filter);
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(state.iterations() * screen_size * screen_size);
+}
+
+void BM_BuildMipChain(benchmark::State& state) {
+    ThreadPool pool(static_cast<int>(state.range(0)));
+    for (auto _ : state) {
+        state.PauseTiming();
+        Texture2D texture = create_pattern(Raster::TEXTURE_LAYOUT);
+        state.ResumeTiming();
+
+        const MipChain chain(std::move(texture), pool);
+        benchmark::DoNotOptimize(chain.get_levels_count());
+    }
+}
+
+void BM_CompressMipChain(benchmark::State& state) {
+    const auto format = static_cast<BlockTexture::Format>(state.range(0));
+    ThreadPool pool(1);
+    for (auto _ : state) {
+        state.PauseTiming();
+        MipChain chain(create_pattern(Raster::TEXTURE_LAYOUT), pool);
+        state.ResumeTiming();
+
+        chain.compress(format);
+        benchmark::DoNotOptimize(chain.get_compressed_level(0).data());
+    }
+}
+
+void BM_LoadTexture(benchmark::State& state) {
+    std::string content(static_cast<size_t>(Raster::TEXTURE_WIDTH) * Raster::TEXTURE_HEIGHT * 3, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>(i * 31);
+    }
+    const TempFile file("akg_bench_texture.raw", content);
+
+    for (auto _ : state) {
+        auto texture = Raster::load_texture(file.get_path());
+        benchmark::DoNotOptimize(texture.data());
+    }
+
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(file.get_size()));
+}
+
+// Mapping alone, pages of the file are only read in when texels are touched
+void BM_MapTexture(benchmark::State& state) {
+    const std::string content(static_cast<size_t>(Raster::TEXTURE_WIDTH) * Raster::TEXTURE_HEIGHT * 3, '\0');
+    const TempFile file("akg_bench_mapped.raw", content);
+
+    for (auto _ : state) {
+        auto texture = Raster::map_texture(file.get_path());
+        benchmark::DoNotOptimize(texture.get(0, 0));
+    }
+}
+
+}
+
+// Specular modes are Off, Exact, Table and Squaring
+BENCHMARK(BM_ShadeFragments)->ArgName("specular")->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_ShadeFragmentBatches)->ArgName("specular")->DenseRange(0, 3)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SampleTexture)
+    ->ArgNames({"morton", "angle", "scale"})
+    ->ArgsProduct({{0, 1}, {0, 30, 90}, {1, 4, 16}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SampleMipChain)
+    ->ArgNames({"filter", "scale", "compressed"})
+    ->ArgsProduct({{0, 1, 2}, {1, 4, 16}, {0, 1}})
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_BuildMipChain)->ArgName("threads")->Arg(1)->Arg(4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_CompressMipChain)->ArgName("format")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_LoadTexture)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_MapTexture)->Unit(benchmark::kMicrosecond);
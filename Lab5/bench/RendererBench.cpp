@@ -0,0 +1,106 @@
+#include "Renderer.hpp"
+#include <benchmark/benchmark.h>
+#include <memory>
+
+namespace {
+
+constexpr int FRAME_WIDTH{1600};
+constexpr int FRAME_HEIGHT{900};
+
+// The default camera looks at the origin from a distance of 5, 
+// in the z = 0 plane one world unit covers this many pixels
+constexpr float PIXELS_PER_UNIT{217.3f};
+
+struct Mesh {
+    Vertices vertices;
+    Faces faces;
+    Vertices normals;
+    TextureVertices texture_vertices;
+    MaterialIds material_ids;
+};
+
+// Grid of cells covering the frame, each cell is split into two front-facing triangles
+Mesh create_grid(int cell_width, int cell_height) {
+    const int columns = (FRAME_WIDTH + cell_width - 1) / cell_width;
+    const int rows = (FRAME_HEIGHT + cell_height - 1) / cell_height;
+
+    Mesh mesh;
+    mesh.normals.push_back({0, 0, 1});
+
+    for (int y = 0; y <= rows; ++y) {
+        for (int x = 0; x <= columns; ++x) {
+            const float screen_x = static_cast<float>(x * cell_width);
+            const float screen_y = static_cast<float>(y * cell_height);
+            mesh.vertices.push_back({
+                (screen_x - FRAME_WIDTH / 2) / PIXELS_PER_UNIT,
+                (FRAME_HEIGHT / 2 - screen_y) / PIXELS_PER_UNIT,
+                0
+            });
+            mesh.texture_vertices.push_back({
+                static_cast<float>(x) / columns,
+                static_cast<float>(y) / rows
+            });
+        }
+    }
+
+    auto get_vertex = [&](int x, int y) {
+        const auto index = static_cast<uint32_t>(y * (columns + 1) + x);
+        return std::array<uint32_t, 3>{index, index, 0};
+    };
+
+    // Screen y grows downwards, so this order is counter-clockwise in the world
+    for (int y = 0; y < rows; ++y) {
+        for (int x = 0; x < columns; ++x) {
+            mesh.faces.push_back({get_vertex(x, y + 1), get_vertex(x + 1, y + 1), get_vertex(x + 1, y)});
+            mesh.faces.push_back({get_vertex(x, y + 1), get_vertex(x + 1, y), get_vertex(x, y)});
+            mesh.material_ids.insert(mesh.material_ids.end(), 2, 0);
+        }
+    }
+
+    return mesh;
+}
+
+Renderer& get_renderer() {
+    // Textures are loaded once for all the benchmarks
+    static Renderer renderer;
+    static const auto camera = std::make_shared<Camera>();
+    renderer.set_camera(camera);
+    renderer.wait_for_textures();
+    return renderer;
+}
+
+void BM_DrawTriangles(benchmark::State& state, int cell_width, int cell_height) {
+    auto& renderer = get_renderer();
+    renderer.set_raster_mode(state.range(0) 
+        ? Renderer::RasterMode::HalfSpace 
+        : Renderer::RasterMode::Scanline);
+
+    const Mesh mesh = create_grid(cell_width, cell_height);
+    float transform_time = 0;
+    float tiles_time = 0;
+
+    for (auto _ : state) {
+        renderer.draw(mesh.vertices, mesh.faces, mesh.normals, mesh.texture_vertices, mesh.material_ids);
+        benchmark::DoNotOptimize(renderer.data());
+
+        const auto& stats = renderer.get_stats();
+        transform_time += stats.transform_time;
+        tiles_time += stats.tiles_time;
+    }
+
+    const auto iterations = static_cast<double>(state.iterations());
+    state.counters["triangles"] = benchmark::Counter(mesh.faces.size() * iterations, benchmark::Counter::kIsRate);
+    state.counters["pixels"] = benchmark::Counter(FRAME_WIDTH * FRAME_HEIGHT * iterations, benchmark::Counter::kIsRate);
+    state.counters["transform_ms"] = benchmark::Counter(transform_time, benchmark::Counter::kAvgIterations);
+    state.counters["tiles_ms"] = benchmark::Counter(tiles_time, benchmark::Counter::kAvgIterations);
+}
+
+}
+
+// Tiles are drawn by the thread pool, so the rates are measured against the wall clock
+BENCHMARK_CAPTURE(BM_DrawTriangles, small, 4, 4)
+    ->ArgName("half_space")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_DrawTriangles, medium, 64, 64)
+    ->ArgName("half_space")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_DrawTriangles, screen, FRAME_WIDTH, FRAME_HEIGHT)
+    ->ArgName("half_space")->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
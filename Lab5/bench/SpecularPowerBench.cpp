@@ -0,0 +1,51 @@
+#include "SpecularPower.hpp"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+constexpr int SAMPLES_COUNT{4096};
+constexpr unsigned SEED{42};
+constexpr float SHININESS{250.0f};
+
+// N·H values around the highlight, where none of the modes can skip the work
+std::vector<float> create_samples() {
+    std::mt19937 generator(SEED);
+    std::uniform_real_distribution<float> distribution(0.95f, 1.0f);
+
+    std::vector<float> samples(SAMPLES_COUNT);
+    std::ranges::generate(samples, [&] { return distribution(generator); });
+    return samples;
+}
+
+void BM_SpecularPower(benchmark::State& state) {
+    const auto mode = static_cast<SpecularPower::Mode>(state.range(0));
+    const float max_error = std::pow(10.0f, -static_cast<float>(state.range(1)));
+    const SpecularPower power(SHININESS, max_error);
+    const std::vector<float> samples = create_samples();
+
+    for (auto _ : state) {
+        for (float x : samples) {
+            benchmark::DoNotOptimize(power.evaluate(x, mode));
+        }
+    }
+
+    double error = 0;
+    for (float x : samples) {
+        error = std::max(error, std::abs(static_cast<double>(power.evaluate(x, mode)) - std::pow(x, SHININESS)));
+    }
+
+    state.SetItemsProcessed(state.iterations() * SAMPLES_COUNT);
+    state.counters["max_error"] = error;
+    state.counters["table_size"] = power.get_table_size();
+}
+
+}
+
+// Modes are Exact, Table and Squaring, the second argument is the error bound as 10^-n
+BENCHMARK(BM_SpecularPower)
+    ->ArgNames({"mode", "error_exp"})
+    ->ArgsProduct({{0, 1, 2}, {3, 5}})
+    ->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,34 @@
+#pragma once
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+// File in the temporary directory that is removed together with the object
+class TempFile final {
+public:
+    TempFile(const std::string& name, const std::string& content)
+        : m_path(std::filesystem::temp_directory_path() / name)
+    {
+        std::ofstream file(m_path, std::ios::binary);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    ~TempFile() {
+        std::error_code error;
+        std::filesystem::remove(m_path, error);
+    }
+
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
+
+    std::string get_path() const {
+        return m_path.string();
+    }
+
+    size_t get_size() const {
+        return static_cast<size_t>(std::filesystem::file_size(m_path));
+    }
+
+private:
+    std::filesystem::path m_path;
+};
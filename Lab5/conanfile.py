@@ -1,20 +1,29 @@
 from conan import ConanFile
-from conan.tools.cmake import cmake_layout, CMake
+from conan.tools.cmake import cmake_layout, CMake, CMakeToolchain
 
 class ExampleRecipe(ConanFile):
     settings = "os", "compiler", "build_type", "arch"
-    generators = "CMakeDeps", "CMakeToolchain"
+    generators = "CMakeDeps"
+    options = {"benchmarks": [True, False]}
+    default_options = {"benchmarks": False}
 
     def requirements(self):
         self.requires("sfml/2.6.2")
         self.requires("nlohmann_json/3.11.3")
         self.requires("glm/1.0.1")
         self.requires("tinygltf/2.9.0")
+        if self.options.benchmarks:
+            self.requires("benchmark/1.9.1")
 
     def layout(self):
         cmake_layout(self)
 
+    def generate(self):
+        toolchain = CMakeToolchain(self)
+        toolchain.cache_variables["AKG_BUILD_BENCHMARKS"] = bool(self.options.benchmarks)
+        toolchain.generate()
+
     def build(self):
         cmake = CMake(self)
         cmake.configure()
-        cmake.build()
\ No newline at end of file
+        cmake.build()
@@ -0,0 +1,87 @@
+#pragma once
+#include "Texture2D.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Texture compressed in 4x4 blocks of 8 bytes, 8 times smaller than Texture2D. BC1 keeps
+// two RGB565 endpoints and a 2 bit palette index per texel, BC4 keeps one 8 bit channel
+// as two endpoints and 3 bit indices and decodes it to gray. Texels are decoded on access
+// a whole block at a time, the last blocks read on each thread are kept decoded
+class BlockTexture final {
+public:
+    enum class Format : uint32_t {
+        BC1,
+        BC4
+    };
+
+    static constexpr int BLOCK_SIZE = 4;
+    static constexpr int BLOCK_TEXELS = BLOCK_SIZE * BLOCK_SIZE;
+    static constexpr size_t BLOCK_BYTES = 8;
+
+    BlockTexture() noexcept = default;
+
+    // Takes encoded blocks in row order, throws std::invalid_argument when their size
+    // does not match the texture
+    BlockTexture(int width, int height, Format format, std::vector<uint8_t> blocks);
+
+    // Reads get_blocks_size bytes of blocks kept alive by the caller, such as a mapped 
+    // file, without copying them. Throws std::invalid_argument when the size is not positive
+    static BlockTexture view(int width, int height, Format format, const uint8_t* blocks);
+
+    static BlockTexture compress(const Texture2D& texture, Format format);
+    static size_t get_blocks_size(int width, int height);
+
+    uint32_t get(int x, int y) const {
+        const int block_x = x / BLOCK_SIZE;
+        const int block_y = y / BLOCK_SIZE;
+        const uint64_t key = m_key | static_cast<uint32_t>(block_y * m_blocks_x + block_x);
+        CachedBlock& cached = s_cache[m_cache_area | 
+            ((block_y & CACHE_AREA_MASK) << CACHE_AREA_BITS) | (block_x & CACHE_AREA_MASK)];
+        if (cached.key != key) {
+            decode_block(block_x, block_y, cached.texels);
+            cached.key = key;
+        }
+        return cached.texels[(y % BLOCK_SIZE) * BLOCK_SIZE + x % BLOCK_SIZE];
+    }
+
+    // Texels of a block in row order, the ones past the edges of the texture included
+    void decode_block(int block_x, int block_y, uint32_t* texels) const;
+
+    int get_width() const { return m_width; }
+    int get_height() const { return m_height; }
+
+    Format get_format() const;
+    size_t size() const;
+    const uint8_t* data() const;
+
+private:
+    // Decoded blocks kept per thread: an 8x8 area of blocks for each of four textures, 
+    // enough for the footprint of a raster block and the two levels of the trilinear filter
+    static constexpr int CACHE_AREA_BITS = 3;
+    static constexpr int CACHE_AREA_MASK = (1 << CACHE_AREA_BITS) - 1;
+    static constexpr int CACHE_TEXTURE_BITS = 2;
+    static constexpr int CACHE_BLOCKS = 1 << (2 * CACHE_AREA_BITS + CACHE_TEXTURE_BITS);
+
+    // Keys hold the texture id in the upper half, ids start from 1 so zeroed slots are empty
+    struct CachedBlock {
+        uint64_t key;
+        uint32_t texels[BLOCK_TEXELS];
+    };
+
+    static inline thread_local std::array<CachedBlock, CACHE_BLOCKS> s_cache{};
+
+    // Copies share the blocks, a view does not own them
+    std::shared_ptr<const uint8_t> m_blocks;
+    size_t m_size{};
+    // Unique id of the blocks in the per-thread cache, they never change after 
+    // construction, so copies may share it
+    uint64_t m_key{};
+    int m_cache_area{};
+    int m_width{};
+    int m_height{};
+    int m_blocks_x{};
+    Format m_format{Format::BC1};
+};
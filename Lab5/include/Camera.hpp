@@ -9,11 +9,15 @@ public:
     void move(const glm::vec3& move_vector);
     void rotate(const glm::vec3& rotation_vector);
     void scale(bool mode);
+    void look_at(const glm::vec3& eye, const glm::vec3& target);
     
     glm::vec3 get_eye() const;
     glm::vec3 get_target() const;
     glm::vec3 get_up() const;
     float get_scale() const;
+
+private:
+    void update_orientation();
     
 private:
     glm::vec3 m_eye{0.0, 0.0, 5.0};
@@ -0,0 +1,35 @@
+#pragma once
+#include "Camera.hpp"
+#include "Scene.hpp"
+#include "Renderer.hpp"
+#include <string>
+
+// Renders a fixed number of frames without a window: the camera orbits the model 
+// along a scripted path and the animation advances one frame per rendered frame, 
+// so every run draws the same images. Timings are written to a JSON report
+class HeadlessRunner final {
+public:
+    HeadlessRunner(int frames_count, std::string output_path, bool texture_compression = false) noexcept;
+
+    [[nodiscard]] bool run();
+
+private:
+    struct FrameTimings {
+        Renderer::Stats stats;
+        float upload_time;
+        float frame_time;
+    };
+
+    void update_camera(int frame);
+    void upload();
+    [[nodiscard]] bool write_report() const;
+
+private:
+    int m_frames_count;
+    std::string m_output_path;
+    Renderer m_renderer;
+    Scene m_scene;
+    std::shared_ptr<Camera> m_camera;
+    std::vector<uint8_t> m_frame;
+    std::vector<FrameTimings> m_timings;
+};
@@ -3,6 +3,7 @@
 #include <memory>
 #include "FPSCounter.hpp"
 #include "Camera.hpp"
+#include "Renderer.hpp"
 
 class Logger {
 public:
@@ -13,12 +14,16 @@ public:
 
     void set_fps_counter(std::shared_ptr<FPSCounter> counter);
     void set_camera(std::shared_ptr<Camera> camera);
+    void set_render_stats(const Renderer::Stats& stats);
+    void set_render_modes(std::string modes);
     void draw(sf::RenderWindow& window) const;
     void update();
 
 private:
     std::shared_ptr<Camera> m_camera;
     std::shared_ptr<FPSCounter> m_counter;
+    Renderer::Stats m_stats{};
+    std::string m_modes;
     sf::Text m_text;
     sf::Font m_font;
 };
\ No newline at end of file
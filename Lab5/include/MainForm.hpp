@@ -5,10 +5,11 @@
 #include "Logger.hpp"
 #include "Scene.hpp"
 #include "Renderer.hpp"
+#include "ResolutionController.hpp"
 
 class MainForm final {
 public:
-    MainForm() noexcept;
+    explicit MainForm(bool texture_compression = false) noexcept;
     
     void run_main_loop();
     
@@ -17,10 +18,16 @@ private:
     void handle_mouse();
     void handle_keyboard();
     void draw();
+    // Smoothing samples one texel past a frame smaller than the texture, so the edge of the
+    // frame is repeated there to keep the texels of an earlier, larger frame from bleeding in
+    void pad_frame(const uint8_t* pixels, int width, int height);
+    // Current render modes for the overlay, the keys in on_key_press switch them
+    std::string get_render_modes() const;
     
 private:
     sf::RenderWindow m_window;
     sf::Texture m_texture;
+    std::vector<uint8_t> m_edge;
     Renderer m_renderer;
     Scene m_scene;
     Logger m_logger;
@@ -30,5 +37,6 @@ private:
 
     sf::Vector2i m_mouse_press_position{};
     sf::Vector2i m_center{};
+    ResolutionController m_resolution;
     float m_delta_time{1.0};
 };
@@ -17,7 +17,8 @@ using Faces = std::vector<Face>;
 using Vertices = std::vector<Vertex>;
 using ScreenVertices = std::vector<ScreenVertex>;
 using TextureVertices = std::vector<TextureVertex>;
-using Mtls = std::vector<int>;
+// Material of each face, in the order the materials are first used in the file
+using MaterialIds = std::vector<uint32_t>;
 
 constexpr float PI = std::numbers::pi_v<float>;
 constexpr float TWO_PI = 2.f * PI;
@@ -0,0 +1,55 @@
+#pragma once
+#include "Texture2D.hpp"
+#include "BlockTexture.hpp"
+#include "MappedFile.hpp"
+#include "ThreadPool.hpp"
+#include <string>
+#include <vector>
+
+// Texture with all its mip levels down to 1x1, each level averages 2x2 texels of the 
+// previous one. Level of detail is log2 of texels per pixel, 0 is the full resolution.
+// A compressed chain keeps every level as a BlockTexture and samples them the same way
+class MipChain final {
+public:
+    enum class Filter {
+        Nearest,    // Point sample of the nearest level
+        Bilinear,   // Four texels of the nearest level
+        Trilinear   // Bilinear samples of the two closest levels blended
+    };
+
+    MipChain() noexcept = default;
+
+    // Levels are downsampled on the calling thread
+    explicit MipChain(Texture2D base);
+
+    // Levels are downsampled in row bands on the pool
+    MipChain(Texture2D base, ThreadPool& pool);
+
+    // Encodes every level and frees the uncompressed ones
+    void compress(BlockTexture::Format format);
+
+    // Writes the chain in the form load reads, both throw std::runtime_error on failure.
+    // A loaded chain samples the mapped file in place, so levels never read take no memory
+    void save(const std::string& filename) const;
+    static MipChain load(const std::string& filename);
+
+    uint32_t sample(float u, float v, float lod, Filter filter) const;
+    uint32_t sample_nearest(float u, float v, int level) const;
+    uint32_t sample_bilinear(float u, float v, int level) const;
+
+    // Level the nearest and bilinear filters read for the given level of detail
+    int get_level_index(float lod) const;
+    const Texture2D& get_level(int level) const;
+    const BlockTexture& get_compressed_level(int level) const;
+    int get_levels_count() const;
+    bool is_compressed() const;
+
+private:
+    void build_levels(ThreadPool* pool);
+    static void downsample_rows(const Texture2D& source, Texture2D& target, int y0, int y1);
+
+    std::vector<Texture2D> m_levels;
+    std::vector<BlockTexture> m_compressed;
+    // Holds the levels of a loaded chain
+    MappedFile m_file;
+};
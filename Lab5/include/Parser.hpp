@@ -1,5 +1,6 @@
 #pragma once
 #include "Matrix.hpp"
+#include "ThreadPool.hpp"
 #include <string>
 #include <memory>
 
@@ -13,18 +14,30 @@ public:
 
     virtual void parse_file(const std::string& file_path) = 0;
     
-    Vertices get_vertices() const;
-    Faces get_faces() const;
-    Vertices get_normals() const;
-    TextureVertices get_texture_vertices() const;
-    Mtls get_mtls() const;
+    // Getters of a parser that is no longer needed move the records out
+    Vertices get_vertices() const&;
+    Vertices get_vertices() &&;
+    Faces get_faces() const&;
+    Faces get_faces() &&;
+    Vertices get_normals() const&;
+    Vertices get_normals() &&;
+    TextureVertices get_texture_vertices() const&;
+    TextureVertices get_texture_vertices() &&;
+    MaterialIds get_material_ids() const&;
+    MaterialIds get_material_ids() &&;
+
+    // Binary cache of the records parsed from a source file with the given content hash. 
+    // Load returns false when the cache was written for other content and throws 
+    // std::runtime_error when it is damaged or of another version
+    void save(const std::string& filename, uint64_t source_hash) const;
+    bool load(const std::string& filename, uint64_t source_hash);
     
 protected:
     Vertices m_vertices;
     Faces m_faces;
     Vertices m_normals;
     TextureVertices m_texture_vertices;
-    Mtls m_mtls;
+    MaterialIds m_material_ids;
 };
 
 class ParserOBJ final : public Parser {
@@ -32,5 +45,20 @@ public:
     ParserOBJ() noexcept = default;
     ~ParserOBJ() noexcept = default;
 
+    // Files of a few megabytes and more are split into chunks at line ends and parsed 
+    // on this many threads, with the same result as on one
+    void set_threads_count(int threads_count);
+
+    // Records of each file are kept in a binary cache next to it, <file>.mesh, which is 
+    // read instead of the text as long as the content of the file stays the same
+    void set_cache_enabled(bool enabled);
+
     void parse_file(const std::string& file_path) override;
+
+private:
+    void parse_text(const char* begin, const char* end);
+
+    std::unique_ptr<ThreadPool> m_pool;
+    int m_threads_count{1};
+    bool m_cache_enabled{true};
 };
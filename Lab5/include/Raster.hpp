@@ -1,6 +1,10 @@
 #pragma once
 #include "Matrix.hpp"
 #include "Color.hpp"
+#include "SpecularPower.hpp"
+#include "Texture2D.hpp"
+#include "MipChain.hpp"
+#include "RawTexture.hpp"
 #include <string>
 
 class Raster final{
@@ -11,23 +15,112 @@ public:
         const TextureVertex& texture;
     };
 
-    Raster() noexcept;
+    using Texture = Texture2D;
+
+    // Textures of a material, indices into the diffuse, normal and specular arrays
+    struct Material {
+        int diffuse;
+        int normal;
+        int specular;
+    };
+
+    static constexpr int BATCH_SIZE = 8;
+    static constexpr uint32_t FULL_BATCH = (1u << BATCH_SIZE) - 1;
+
+    // How the specular power is evaluated, see SpecularPower::Mode. Off leaves the highlights out
+    enum class SpecularMode {
+        Off,
+        Exact,
+        Table,
+        Squaring
+    };
+
+    // Fragments shaded together by get_colors, in structure of arrays layout
+    struct FragmentBatch {
+        alignas(32) float world_x[BATCH_SIZE];
+        alignas(32) float world_y[BATCH_SIZE];
+        alignas(32) float world_z[BATCH_SIZE];
+        alignas(32) float normal_x[BATCH_SIZE];
+        alignas(32) float normal_y[BATCH_SIZE];
+        alignas(32) float normal_z[BATCH_SIZE];
+        alignas(32) float u[BATCH_SIZE];
+        alignas(32) float v[BATCH_SIZE];
+    };
+
+    static constexpr int TEXTURES_COUNT = 4;
+    static constexpr int TEXTURE_WIDTH = 2048;
+    static constexpr int TEXTURE_HEIGHT = 2048;
+    static constexpr Texture2D::Layout TEXTURE_LAYOUT = Texture2D::Layout::Morton;
+
+    // Starts loading the textures in the background, 1x1 placeholders are 
+    // sampled until update_textures swaps the loaded ones in. With compression diffuse 
+    // textures are kept as BC1 and specular ones as BC4, which takes 8 times less memory 
+    // than RGBA, but decoding on sample makes nearest-filtered frames 15-40% slower
+    explicit Raster(bool texture_compression = false) noexcept;
     ~Raster() = default;
 
-    void reset_texture();
-    void next_texture();
+    // Swaps in the textures loaded since the last call. The renderer calls it before 
+    // each frame, so all tiles of a frame see the same textures
+    void update_textures();
+    void wait_for_textures();
+    int get_pending_textures() const;
+    bool get_texture_compression() const;
 
     void set_eye(const glm::vec3& eye);
     void set_sun(const glm::vec3& sun);
     
-    Color::RGBA get_color(const PointData& p);
+    void set_specular_mode(SpecularMode mode);
+    SpecularMode get_specular_mode() const;
+    void set_specular_error(float max_error);
+    float get_specular_error() const;
+    void set_texture_filter(MipChain::Filter filter);
+    MipChain::Filter get_texture_filter() const;
+    int get_materials_count() const;
+    
+    // Level of detail is log2 of texels per pixel, see MipChain
+    Color::RGBA get_color(const PointData& p, int material, float lod) const;
+
+    // Shades the fragments of one material set in the lane mask at once, with AVX2 or SSE4.1 
+    // when the CPU has them, highlights included. The result matches get_color for every 
+    // fragment within one step per channel, colors of the other lanes are left as they are
+    void get_colors(const FragmentBatch& batch, uint32_t mask, int material, float lod, Color::RGBA* colors) const;
+
+    // Reads a TEXTURE_WIDTH x TEXTURE_HEIGHT raw RGB file into the given layout, 
+    // throws std::runtime_error on failure
+    static Texture load_texture(const std::string& filename, Texture2D::Layout layout = TEXTURE_LAYOUT);
+
+    // Maps the same file without converting it, throws std::runtime_error on failure
+    static RawTexture map_texture(const std::string& filename);
+
+    // Maps the mip chain cached next to the raw file, BC1 or BC4 blocks with compression 
+    // and TEXTURE_LAYOUT texels without. The chain is built and cached when there is no 
+    // cache or the raw file is newer, and kept in memory when the cache cannot be written. 
+    // Throws std::runtime_error when neither file can be read
+    static MipChain load_cached(const std::string& filename, bool compress, BlockTexture::Format format);
 
 private:
-    std::vector<std::vector<std::vector<uint32_t>>> arr_diffuse;
-    std::vector<std::vector<std::vector<uint32_t>>> arr_normal;
-    std::vector<std::vector<std::vector<uint32_t>>> arr_specular;
+    struct PendingTexture {
+        MipChain* target;
+        std::future<std::any> result;
+    };
+
+    void start_loading(MipChain& target, const std::string& filename, BlockTexture::Format format);
+
+private:
+    std::vector<MipChain> arr_diffuse;
+    std::vector<RawTexture> arr_normal;
+    std::vector<MipChain> arr_specular;
+    std::vector<Material> m_materials;
 
     glm::vec3 m_eye, m_sun;
-    int index{};
+    SpecularMode m_specular_mode{SpecularMode::Off};
+    SpecularPower m_specular;
+    MipChain::Filter m_texture_filter{MipChain::Filter::Nearest};
+    bool m_use_avx2{};
+    bool m_use_sse41{};
+    bool m_texture_compression{};
+
+    std::vector<PendingTexture> m_pending;
+    ThreadPool m_loader;
 };
 
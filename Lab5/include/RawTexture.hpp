@@ -0,0 +1,36 @@
+#pragma once
+#include "MappedFile.hpp"
+#include <string>
+
+// Raw RGB texture read straight from the mapped file, texels are packed on access 
+// in the same order as Raster::load_texture does
+class RawTexture final {
+public:
+    static constexpr int BYTES_PER_TEXEL = 3;
+
+    RawTexture() noexcept = default;
+
+    // Throws std::runtime_error when the file cannot be mapped or is smaller than the texture
+    RawTexture(const std::string& filename, int width, int height);
+
+    static uint32_t pack(const uint8_t* texel) {
+        return 0xFF000000u | (texel[2] << 16) | (texel[1] << 8) | texel[0];
+    }
+
+    uint32_t get(int x, int y) const {
+        return pack(get_row(y) + x * BYTES_PER_TEXEL);
+    }
+
+    const uint8_t* get_row(int y) const {
+        return m_file.data() + static_cast<size_t>(y) * m_width * BYTES_PER_TEXEL;
+    }
+
+    const uint8_t* data() const;
+    int get_width() const;
+    int get_height() const;
+
+private:
+    MappedFile m_file;
+    int m_width{};
+    int m_height{};
+};
@@ -2,7 +2,9 @@
 #include "Matrix.hpp"
 #include "Camera.hpp"
 #include "Raster.hpp"
+#include "ThreadPool.hpp"
 #include <memory>
+#include <deque>
 
 class Renderer final {
 public:
@@ -13,31 +15,175 @@ public:
         const TextureVertex& texture;
     };
 
-    Renderer() noexcept;
+    enum class RasterMode {
+        Scanline,
+        HalfSpace
+    };
+
+    enum class ShadingMode {
+        Forward,
+        Deferred
+    };
+
+    struct Stats {
+        int faces;
+        int submitted;
+        int clipped;
+        int culled_frustum;
+        int culled_backface;
+        int culled_offscreen;
+        int culled_degenerate;
+        int hiz_tested_blocks;
+        int hiz_rejected_blocks;
+        int hiz_rejected_triangles;
+        int cleared_blocks;
+        int resolved_blocks;
+        int width;
+        int height;
+
+        // Stage timings in milliseconds. Transform covers vertex transform, clipping, 
+        // culling and binning. Raster and shade are summed over all tile tasks, so with 
+        // several threads they exceed tiles_time, the wall time of the tile stage. 
+        // In the forward mode fragments are shaded while rasterizing
+        float transform_time;
+        float raster_time;
+        float shade_time;
+        float tiles_time;
+        float resolve_time;
+        float draw_time;
+    };
+
+    // Texture compression is chosen before the textures start loading, see Raster
+    explicit Renderer(bool texture_compression = false) noexcept;
     ~Renderer() = default;
 
     void set_camera(std::shared_ptr<Camera> camera);
+    void set_resolution(int width, int height);
+    int get_width() const;
+    int get_height() const;
+    void set_raster_mode(RasterMode mode);
+    RasterMode get_raster_mode() const;
+    void set_shading_mode(ShadingMode mode);
+    ShadingMode get_shading_mode() const;
+    void set_backface_culling(bool enabled);
+    bool get_backface_culling() const;
+    void set_hierarchical_z(bool enabled);
+    bool get_hierarchical_z() const;
+    void set_specular_mode(Raster::SpecularMode mode);
+    Raster::SpecularMode get_specular_mode() const;
+    // Error bound of the table, and the cutoff of the table and squaring modes
+    void set_specular_error(float max_error);
+    float get_specular_error() const;
+    void set_texture_filter(MipChain::Filter filter);
+    MipChain::Filter get_texture_filter() const;
+    // Textures load in the background and are picked up by draw as they become ready
+    void wait_for_textures();
+    bool get_texture_compression() const;
+    const Stats& get_stats() const;
     const uint8_t* data() const;
     void clear_bitmap();
+    // Takes one material id per face, faces do not depend on each other
     void draw(const Vertices& vertices, 
               const Faces& faces,
               const Vertices& normals, 
               const TextureVertices& texture_vertices,
-              const Mtls& mtls
+              const MaterialIds& material_ids
             );
 
 private:
+    struct Triangle {
+        PointData p1;
+        PointData p2;
+        PointData p3;
+        int material;
+        // Set by bin_triangle from the texture and screen areas of the triangle
+        float lod{};
+    };
+
+    struct Tile {
+        int x0, y0;
+        int x1, y1;
+        int index;
+    };
+
+    struct TileStats {
+        int hiz_tested_blocks;
+        int hiz_rejected_blocks;
+        int hiz_rejected_triangles;
+        int cleared_blocks;
+        float raster_time;
+        float shade_time;
+    };
+
+    // Vertex created by clipping, screen holds clip-space position until projected
+    struct ClippedVertex {
+        Vertex world;
+        ScreenVertex screen;
+        Vertex normal;
+        TextureVertex texture;
+    };
+
+    static constexpr int MAX_CLIPPED_VERTICES = 9;
+    using ClippedPolygon = std::array<ClippedVertex, MAX_CLIPPED_VERTICES>;
+
+    // Perspective-correct barycentrics of p1 and p2 of the nearest triangle
+    struct VisibilitySample {
+        uint32_t triangle;
+        float b1, b2;
+    };
+
     glm::mat4x4 get_view_matrix() const;
     glm::mat4x4 get_viewport_matrix() const;
     glm::mat4x4 get_scale_matrix() const;
     glm::mat4x4 get_projection_matrix() const; 
 
-    ScreenVertices get_screen_vertices(const Vertices& vertices) const;
-    void draw_triangle(const PointData& p1, const PointData& p2, const PointData& p3);
+    ScreenVertices get_clip_vertices(const Vertices& vertices) const;
+    static int clip_polygon(ClippedPolygon& polygon, int count, uint8_t planes);
+    void clip_triangle(const ClippedPolygon& polygon, int material, uint8_t planes);
+    void submit_triangle(const Triangle& triangle);
+    bool cull_triangle(const ScreenVertex& s1, const ScreenVertex& s2, const ScreenVertex& s3);
+    void bin_triangle(const Triangle& triangle);
+    void draw_tile(int tile_index);
+    void draw_triangle(uint32_t id, const Tile& tile);
+    void draw_triangle_half_space(uint32_t id, const Tile& tile);
+    void shade_tile(const Tile& tile);
+    int get_block_index(int x, int y) const;
+    void update_hiz(int x0, int y0, int x1, int y1);
+    void clear_block(int block, TileStats& stats);
+    void resolve_blocks();
+    Color::RGBA shade_fragment(const Triangle& triangle, float b1, float b2, float b3) const;
+    void set_fragment(Raster::FragmentBatch& batch, int lane, const Triangle& triangle, 
+                      float b1, float b2, float b3) const;
 
 private:
     Raster m_raster;
+    ThreadPool m_pool;
     std::shared_ptr<Camera> m_camera;
+    // The half-space kernel fills edges by other rules, so it is only used when chosen
+    RasterMode m_raster_mode{RasterMode::Scanline};
+    ShadingMode m_shading_mode{ShadingMode::Forward};
+    bool m_backface_culling{true};
+    bool m_hierarchical_z{true};
+    Stats m_stats{};
+    bool m_use_avx2{};
+    int m_width{};
+    int m_height{};
+    int m_tiles_x{};
+    int m_tiles_y{};
+    int m_blocks_x{};
+    int m_blocks_y{};
     std::vector<Color::RGBA> m_data; 
     std::vector<float> m_z_buffer;
+    std::vector<VisibilitySample> m_visibility;
+    std::vector<float> m_hiz;
+    std::vector<uint8_t> m_block_flags;
+
+    ScreenVertices m_clip_vertices;
+    ScreenVertices m_screen_vertices;
+    std::vector<uint8_t> m_clip_codes;
+    std::deque<ClippedVertex> m_clipped_vertices;
+
+    std::vector<Triangle> m_triangles;
+    std::vector<std::vector<uint32_t>> m_bins;
+    std::vector<TileStats> m_tile_stats;
 };
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+
+// Picks the internal render resolution from the measured frame time: when frames take 
+// longer than the target the resolution drops, when there is headroom it climbs back
+class ResolutionController final {
+public:
+    ResolutionController(int max_width, int max_height, float target_fps) noexcept;
+
+    void update(float frame_time);
+    void set_enabled(bool enabled);
+    bool get_enabled() const;
+    int get_width() const;
+    int get_height() const;
+    float get_scale() const;
+
+private:
+    int m_max_width;
+    int m_max_height;
+    float m_target_frame_time;
+    float m_average_frame_time;
+    float m_scale{1.0f};
+    int m_cooldown{};
+    bool m_enabled{true};
+};
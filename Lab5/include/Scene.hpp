@@ -1,33 +1,48 @@
 #pragma once
 #include "Parser.hpp"
 #include "Camera.hpp"
+#include "ThreadPool.hpp"
 #include <SFML/System/Clock.hpp>
+#include <atomic>
+#include <functional>
 
 struct Model {
     Vertices m_vertices;
     Faces m_faces;
     Vertices m_normals;
     TextureVertices m_texture_vertices;
-    Mtls m_mtls;
+    MaterialIds m_material_ids;
 };
 
 class Scene {
 public:
-    Scene() noexcept = default;
-    virtual ~Scene() = default;
+    // Called on the thread of initialize and update as each frame becomes ready, 
+    // frames are loaded in parallel but reported in order
+    using ProgressCallback = std::function<void(int loaded, int total)>;
 
-    [[nodiscard]] bool initialize();
+    Scene() noexcept;
+    // Frames still queued are dropped instead of waiting for them to be parsed
+    virtual ~Scene();
+
+    // Returns once the first frame is loaded, the others stream in the background
+    [[nodiscard]] bool initialize(const ProgressCallback& on_progress = {});
     void rotate_model(const glm::vec3& rotate_vector);
     void move_model(const glm::vec3& move_vector);
+    // Advances the animation only to loaded frames and holds the last of them otherwise
     void update();
+    void set_frame(int frame);
+    void wait_for_frames();
 
     Vertices get_vertices() const;
     const Faces& get_faces() const;
     Vertices get_normals() const;
     const TextureVertices& get_texture_vertices() const;
-    const Mtls& get_mtls() const;
+    const MaterialIds& get_material_ids() const;
 
 private:
+    // Moves frames that finished loading into m_models, in order
+    void update_frames();
+
     glm::vec3 m_model_position{};
     glm::vec3 m_model_rotation{};
     std::vector<Model> m_models;
@@ -35,4 +50,11 @@ private:
 
     sf::Clock m_clock;
     sf::Time m_elapsed_time{};
+
+    std::vector<std::string> m_paths;
+    std::vector<std::future<std::any>> m_pending;
+    ProgressCallback m_on_progress;
+    // Checked by loading tasks before parsing, the pool runs all queued tasks before it stops
+    std::atomic<bool> m_cancelled{false};
+    ThreadPool m_loader;
 };
\ No newline at end of file
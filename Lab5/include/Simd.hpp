@@ -0,0 +1,21 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AKG_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define AKG_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define AKG_TARGET_SSE41 __attribute__((target("sse4.1")))
+#else
+#define AKG_TARGET_AVX2
+#define AKG_TARGET_SSE41
+#endif
+
+namespace Simd {
+
+    bool has_avx2();
+    bool has_sse41();
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Simd.hpp"
+#include <vector>
+
+// Evaluates x^exponent for x in [0, 1], the specular highlight of a material with the given 
+// shininess. Besides std::pow there is a lookup table sized so that its absolute error stays 
+// under max_error, and exponentiation by squaring for integer exponents
+class SpecularPower final {
+public:
+    enum class Mode {
+        Exact,      // std::pow
+        Table,      // Interpolated samples, within max_error
+        Squaring    // Exact for integer exponents, zero where the power is under max_error
+    };
+
+    SpecularPower(float exponent, float max_error) noexcept;
+
+    float evaluate(float x, Mode mode) const;
+    float exact(float x) const;
+    float table(float x) const;
+    float squaring(float x) const;
+
+#ifdef AKG_SIMD_X86
+    // Lane by lane the same as evaluate, Exact still calls std::pow for every lane
+    AKG_TARGET_AVX2 __m256 evaluate_avx2(__m256 x, Mode mode) const;
+    AKG_TARGET_SSE41 __m128 evaluate_sse41(__m128 x, Mode mode) const;
+#endif
+
+    float get_exponent() const;
+    float get_max_error() const;
+    int get_table_size() const;
+
+private:
+    float m_exponent;
+    float m_max_error;
+    float m_cutoff;
+    float m_inv_step;
+    int m_integer_exponent;
+    std::vector<float> m_table;
+};
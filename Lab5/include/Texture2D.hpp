@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// RGBA texture in one 64 byte aligned allocation. In the Morton layout texels are stored 
+// in Z-order, so neighbours in both directions share cache lines: a 4x4 block fills one line. 
+// The index of a texel is the sum of per column and per row offsets looked up in two small 
+// tables, which is cheaper than interleaving the bits of x and y on every access
+class Texture2D final {
+public:
+    enum class Layout {
+        Linear,
+        Morton
+    };
+
+    static constexpr size_t ALIGNMENT = 64;
+
+    Texture2D() noexcept = default;
+    Texture2D(int width, int height, Layout layout = Layout::Linear, uint32_t fill = 0);
+
+    // Reads get_size texels kept alive by the caller, such as a mapped file, without 
+    // copying them. The view is read-only, set must not be called on it
+    static Texture2D view(int width, int height, Layout layout, const uint32_t* texels);
+
+    // Texels of the allocation, a Morton texture covers a power of two square. 
+    // Throws std::invalid_argument when the size is not positive or too large
+    static size_t get_size(int width, int height, Layout layout);
+
+    uint32_t get(int x, int y) const { return m_data[get_index(x, y)]; }
+    void set(int x, int y, uint32_t color) { m_storage[get_index(x, y)] = color; }
+
+    size_t get_index(int x, int y) const { return m_offsets_x[x] + m_offsets_y[y]; }
+    int get_width() const { return m_width; }
+    int get_height() const { return m_height; }
+
+    Layout get_layout() const;
+    size_t size() const;
+    const uint32_t* data() const;
+    // Null for a view
+    uint32_t* data();
+
+private:
+    struct Deleter {
+        void operator()(uint32_t* data) const;
+    };
+
+    void set_layout(int width, int height, Layout layout);
+
+    std::unique_ptr<uint32_t[], Deleter> m_storage;
+    const uint32_t* m_data{};
+    std::vector<size_t> m_offsets_x;
+    std::vector<size_t> m_offsets_y;
+    size_t m_size{};
+    int m_width{};
+    int m_height{};
+    Layout m_layout{Layout::Linear};
+};
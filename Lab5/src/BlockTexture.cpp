@@ -0,0 +1,300 @@
+#include "BlockTexture.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr int AXIS_ITERATIONS{4};
+constexpr uint32_t OPAQUE{0xFF000000};
+
+constexpr uint32_t ID_HASH{0x9E3779B1};
+
+std::atomic<uint32_t> next_id{1};
+
+struct Rgb {
+    int r, g, b;
+};
+
+// Colors hold red in the low byte and blue in bits 16-23, like Color::RGBA
+Rgb unpack(uint32_t color) {
+    return {static_cast<int>(color & 0xFF), static_cast<int>((color >> 8) & 0xFF), static_cast<int>((color >> 16) & 0xFF)};
+}
+
+uint32_t pack(int r, int g, int b) {
+    return OPAQUE | (b << 16) | (g << 8) | r;
+}
+
+int get_distance(const Rgb& c1, const Rgb& c2) {
+    return (c1.r - c2.r) * (c1.r - c2.r) + (c1.g - c2.g) * (c1.g - c2.g) + (c1.b - c2.b) * (c1.b - c2.b);
+}
+
+// Single channel the BC4 format keeps, with the usual luma weights
+int get_luma(uint32_t color) {
+    const auto [r, g, b] = unpack(color);
+    return (77 * r + 150 * g + 29 * b + 128) >> 8;
+}
+
+uint16_t read_u16(const uint8_t* data) {
+    return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+void write_u16(uint8_t* data, uint16_t value) {
+    data[0] = static_cast<uint8_t>(value);
+    data[1] = static_cast<uint8_t>(value >> 8);
+}
+
+uint16_t to_rgb565(const Rgb& color) {
+    const int r = (color.r * 31 + 127) / 255;
+    const int g = (color.g * 63 + 127) / 255;
+    const int b = (color.b * 31 + 127) / 255;
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+// Bits are replicated into the low ones, so 0 and the largest value map to 0 and 255
+Rgb from_rgb565(uint16_t color) {
+    const int r = color >> 11;
+    const int g = (color >> 5) & 0x3F;
+    const int b = color & 0x1F;
+    return {(r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2)};
+}
+
+// With the first endpoint greater the two other colors lie between the endpoints,
+// otherwise they are the midpoint and black
+inline std::array<Rgb, 4> get_bc1_palette(uint16_t color0, uint16_t color1) {
+    const Rgb c0 = from_rgb565(color0);
+    const Rgb c1 = from_rgb565(color1);
+    if (color0 > color1) {
+        return {c0, c1,
+                Rgb{(2 * c0.r + c1.r) / 3, (2 * c0.g + c1.g) / 3, (2 * c0.b + c1.b) / 3},
+                Rgb{(c0.r + 2 * c1.r) / 3, (c0.g + 2 * c1.g) / 3, (c0.b + 2 * c1.b) / 3}};
+    }
+    return {c0, c1, Rgb{(c0.r + c1.r) / 2, (c0.g + c1.g) / 2, (c0.b + c1.b) / 2}, Rgb{0, 0, 0}};
+}
+
+// With the first endpoint greater six values lie between the endpoints,
+// otherwise four do and the last two are 0 and 255
+std::array<int, 8> get_bc4_palette(int value0, int value1) {
+    std::array<int, 8> palette{value0, value1};
+    if (value0 > value1) {
+        for (int i = 1; i < 7; ++i) {
+            palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+        }
+    } else {
+        for (int i = 1; i < 5; ++i) {
+            palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+        }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+    return palette;
+}
+
+// Endpoints are the texels furthest apart along the principal axis of the colors,
+// found by a few power iterations on their covariance
+void encode_bc1(const uint32_t* texels, uint8_t* block) {
+    std::array<Rgb, BlockTexture::BLOCK_TEXELS> colors;
+    float mean[3]{};
+    for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i) {
+        colors[i] = unpack(texels[i]);
+        mean[0] += colors[i].r;
+        mean[1] += colors[i].g;
+        mean[2] += colors[i].b;
+    }
+    for (float& channel : mean) {
+        channel /= BlockTexture::BLOCK_TEXELS;
+    }
+
+    float covariance[3][3]{};
+    for (const Rgb& color : colors) {
+        const float d[3]{color.r - mean[0], color.g - mean[1], color.b - mean[2]};
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                covariance[i][j] += d[i] * d[j];
+            }
+        }
+    }
+
+    float axis[3]{1.0f, 1.0f, 1.0f};
+    for (int iteration = 0; iteration < AXIS_ITERATIONS; ++iteration) {
+        float next[3]{};
+        for (int i = 0; i < 3; ++i) {
+            next[i] = covariance[i][0] * axis[0] + covariance[i][1] * axis[1] + covariance[i][2] * axis[2];
+        }
+        const float length = std::max({std::abs(next[0]), std::abs(next[1]), std::abs(next[2])});
+        if (length == 0.0f) {
+            break;
+        }
+        for (int i = 0; i < 3; ++i) {
+            axis[i] = next[i] / length;
+        }
+    }
+
+    int min_index = 0;
+    int max_index = 0;
+    float min_projection = INFINITY;
+    float max_projection = -INFINITY;
+    for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i) {
+        const float projection = colors[i].r * axis[0] + colors[i].g * axis[1] + colors[i].b * axis[2];
+        if (projection < min_projection) {
+            min_projection = projection;
+            min_index = i;
+        }
+        if (projection > max_projection) {
+            max_projection = projection;
+            max_index = i;
+        }
+    }
+
+    uint16_t color0 = to_rgb565(colors[max_index]);
+    uint16_t color1 = to_rgb565(colors[min_index]);
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    // Equal endpoints leave all indices zero, which picks the first endpoint in both modes
+    uint32_t indices = 0;
+    if (color0 != color1) {
+        const auto palette = get_bc1_palette(color0, color1);
+        for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i) {
+            const auto nearest = std::ranges::min_element(palette, {}, [&](const Rgb& entry) {
+                return get_distance(entry, colors[i]);
+            });
+            indices |= static_cast<uint32_t>(nearest - palette.begin()) << (2 * i);
+        }
+    }
+
+    write_u16(block, color0);
+    write_u16(block + 2, color1);
+    std::memcpy(block + 4, &indices, sizeof(indices));
+}
+
+void encode_bc4(const uint32_t* texels, uint8_t* block) {
+    std::array<int, BlockTexture::BLOCK_TEXELS> values;
+    std::ranges::transform(texels, texels + BlockTexture::BLOCK_TEXELS, values.begin(), get_luma);
+    const auto [min_value, max_value] = std::ranges::minmax(values);
+
+    uint64_t indices = 0;
+    if (max_value != min_value) {
+        const auto palette = get_bc4_palette(max_value, min_value);
+        for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i) {
+            const auto nearest = std::ranges::min_element(palette, {}, [&](int entry) {
+                return std::abs(entry - values[i]);
+            });
+            indices |= static_cast<uint64_t>(nearest - palette.begin()) << (3 * i);
+        }
+    }
+
+    block[0] = static_cast<uint8_t>(max_value);
+    block[1] = static_cast<uint8_t>(min_value);
+    for (int i = 0; i < 6; ++i) {
+        block[2 + i] = static_cast<uint8_t>(indices >> (8 * i));
+    }
+}
+
+void decode_bc1(const uint8_t* block, uint32_t* texels) {
+    const auto [c0, c1, c2, c3] = get_bc1_palette(read_u16(block), read_u16(block + 2));
+    const uint32_t packed[4]{pack(c0.r, c0.g, c0.b), pack(c1.r, c1.g, c1.b), 
+                             pack(c2.r, c2.g, c2.b), pack(c3.r, c3.g, c3.b)};
+
+    uint32_t indices;
+    std::memcpy(&indices, block + 4, sizeof(indices));
+    for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i, indices >>= 2) {
+        texels[i] = packed[indices & 0x3];
+    }
+}
+
+void decode_bc4(const uint8_t* block, uint32_t* texels) {
+    const auto palette = get_bc4_palette(block[0], block[1]);
+    uint64_t indices = 0;
+    for (int i = 0; i < 6; ++i) {
+        indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+    }
+    for (int i = 0; i < BlockTexture::BLOCK_TEXELS; ++i, indices >>= 3) {
+        const int value = palette[indices & 0x7];
+        texels[i] = pack(value, value, value);
+    }
+}
+
+int get_blocks_count(int size) {
+    return (size + BlockTexture::BLOCK_SIZE - 1) / BlockTexture::BLOCK_SIZE;
+}
+
+}
+
+BlockTexture::BlockTexture(int width, int height, Format format, std::vector<uint8_t> blocks)
+    : BlockTexture(view(width, height, format, blocks.data()))
+{
+    if (blocks.size() != m_size) {
+        throw std::invalid_argument("Blocks do not match the texture size");
+    }
+    auto storage = std::make_shared<const std::vector<uint8_t>>(std::move(blocks));
+    m_blocks = std::shared_ptr<const uint8_t>(storage, storage->data());
+}
+
+BlockTexture BlockTexture::view(int width, int height, Format format, const uint8_t* blocks) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Texture size must be positive");
+    }
+
+    BlockTexture texture;
+    texture.m_blocks = std::shared_ptr<const uint8_t>(std::shared_ptr<const uint8_t>{}, blocks);
+    texture.m_size = get_blocks_size(width, height);
+    texture.m_width = width;
+    texture.m_height = height;
+    texture.m_blocks_x = get_blocks_count(width);
+    texture.m_format = format;
+
+    // The hashed id picks the cache area, so textures read together rarely share one
+    const uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+    texture.m_key = static_cast<uint64_t>(id) << 32;
+    texture.m_cache_area = static_cast<int>((id * ID_HASH) >> (32 - CACHE_TEXTURE_BITS)) << (2 * CACHE_AREA_BITS);
+    return texture;
+}
+
+// Blocks past the edges repeat the last row or column
+BlockTexture BlockTexture::compress(const Texture2D& texture, Format format) {
+    const int width = texture.get_width();
+    const int height = texture.get_height();
+    std::vector<uint8_t> blocks(get_blocks_size(width, height));
+
+    uint8_t* block = blocks.data();
+    uint32_t texels[BLOCK_TEXELS];
+    for (int block_y = 0; block_y < get_blocks_count(height); ++block_y) {
+        for (int block_x = 0; block_x < get_blocks_count(width); ++block_x) {
+            for (int i = 0; i < BLOCK_TEXELS; ++i) {
+                const int x = std::min(block_x * BLOCK_SIZE + i % BLOCK_SIZE, width - 1);
+                const int y = std::min(block_y * BLOCK_SIZE + i / BLOCK_SIZE, height - 1);
+                texels[i] = texture.get(x, y);
+            }
+            format == Format::BC4 ? encode_bc4(texels, block) : encode_bc1(texels, block);
+            block += BLOCK_BYTES;
+        }
+    }
+
+    return BlockTexture(width, height, format, std::move(blocks));
+}
+
+size_t BlockTexture::get_blocks_size(int width, int height) {
+    return static_cast<size_t>(get_blocks_count(width)) * get_blocks_count(height) * BLOCK_BYTES;
+}
+
+void BlockTexture::decode_block(int block_x, int block_y, uint32_t* texels) const {
+    const uint8_t* block = m_blocks.get() + (static_cast<size_t>(block_y) * m_blocks_x + block_x) * BLOCK_BYTES;
+    m_format == Format::BC4 ? decode_bc4(block, texels) : decode_bc1(block, texels);
+}
+
+BlockTexture::Format BlockTexture::get_format() const {
+    return m_format;
+}
+
+size_t BlockTexture::size() const {
+    return m_size;
+}
+
+const uint8_t* BlockTexture::data() const {
+    return m_blocks.get();
+}
@@ -30,10 +30,21 @@ void Camera::move(const glm::vec3& move_vector) {
 }
 
 void Camera::rotate(const glm::vec3& rotation_vector) {
-    constexpr float MAX_PITCH = get_radians(89.0);
-
     m_yaw -= rotation_vector.x * ROTATION_SENSITIVITY;
     m_pitch += rotation_vector.y * ROTATION_SENSITIVITY;
+    update_orientation();
+}
+
+void Camera::look_at(const glm::vec3& eye, const glm::vec3& target) {
+    const glm::vec3 forward = glm::normalize(target - eye);
+    m_eye = eye;
+    m_yaw = std::atan2(forward.z, forward.x);
+    m_pitch = std::asin(forward.y);
+    update_orientation();
+}
+
+void Camera::update_orientation() {
+    constexpr float MAX_PITCH = get_radians(89.0);
     m_pitch = std::clamp(m_pitch, -MAX_PITCH, MAX_PITCH);
 
     glm::vec3 forward = glm::normalize(glm::vec3{
@@ -0,0 +1,142 @@
+#include "HeadlessRunner.hpp"
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <nlohmann/json.hpp>
+
+namespace {
+
+constexpr float ORBIT_RADIUS{5.0f};
+constexpr float ORBIT_HEIGHT{1.0f};
+constexpr int ORBIT_FRAMES{240};
+constexpr int REPORT_INDENT{4};
+
+using Clock = std::chrono::steady_clock;
+
+float get_elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+nlohmann::json get_stage_times(const Renderer::Stats& stats) {
+    return {
+        {"transform_ms", stats.transform_time},
+        {"raster_ms", stats.raster_time},
+        {"shade_ms", stats.shade_time},
+        {"tiles_ms", stats.tiles_time},
+        {"resolve_ms", stats.resolve_time},
+        {"draw_ms", stats.draw_time}
+    };
+}
+
+}
+
+HeadlessRunner::HeadlessRunner(int frames_count, std::string output_path, bool texture_compression) noexcept
+    : m_frames_count(frames_count)
+    , m_output_path(std::move(output_path))
+    , m_renderer(texture_compression)
+    , m_camera(std::make_shared<Camera>())
+{
+    m_renderer.set_camera(m_camera);
+}
+
+bool HeadlessRunner::run() {
+    if (!m_scene.initialize()) {
+        return false;
+    }
+    // Timings are meant for all the frames and the real textures, not for the placeholders
+    m_scene.wait_for_frames();
+    m_renderer.wait_for_textures();
+
+    m_timings.clear();
+    m_timings.reserve(m_frames_count);
+
+    for (int frame = 0; frame < m_frames_count; ++frame) {
+        const auto frame_start = Clock::now();
+
+        update_camera(frame);
+        m_scene.set_frame(frame);
+
+        m_renderer.draw(
+            m_scene.get_vertices(), 
+            m_scene.get_faces(), 
+            m_scene.get_normals(), 
+            m_scene.get_texture_vertices(), 
+            m_scene.get_material_ids()
+        );
+
+        const auto upload_start = Clock::now();
+        upload();
+        const float upload_time = get_elapsed_ms(upload_start);
+
+        m_timings.push_back({m_renderer.get_stats(), upload_time, get_elapsed_ms(frame_start)});
+    }
+
+    return write_report();
+}
+
+void HeadlessRunner::update_camera(int frame) {
+    const float angle = 2 * PI * static_cast<float>(frame % ORBIT_FRAMES) / ORBIT_FRAMES;
+    const glm::vec3 eye{ORBIT_RADIUS * std::sin(angle), ORBIT_HEIGHT, ORBIT_RADIUS * std::cos(angle)};
+    m_camera->look_at(eye, glm::vec3{0, 0, 0});
+}
+
+// Stands in for the texture upload of the windowed mode: the frame is copied out 
+// of the renderer into a buffer owned by the caller
+void HeadlessRunner::upload() {
+    const size_t size = static_cast<size_t>(m_renderer.get_width()) * m_renderer.get_height() * 4;
+    m_frame.resize(size);
+    std::copy_n(m_renderer.data(), size, m_frame.begin());
+}
+
+bool HeadlessRunner::write_report() const {
+    nlohmann::json frames = nlohmann::json::array();
+    Renderer::Stats total{};
+    float total_upload_time = 0;
+    float total_frame_time = 0;
+
+    for (int i = 0; i < static_cast<int>(m_timings.size()); ++i) {
+        const auto& [stats, upload_time, frame_time] = m_timings[i];
+
+        nlohmann::json frame = get_stage_times(stats);
+        frame["frame"] = i;
+        frame["upload_ms"] = upload_time;
+        frame["frame_ms"] = frame_time;
+        frame["triangles"] = stats.submitted;
+        frames.push_back(frame);
+
+        total.transform_time += stats.transform_time;
+        total.raster_time += stats.raster_time;
+        total.shade_time += stats.shade_time;
+        total.tiles_time += stats.tiles_time;
+        total.resolve_time += stats.resolve_time;
+        total.draw_time += stats.draw_time;
+        total_upload_time += upload_time;
+        total_frame_time += frame_time;
+    }
+
+    nlohmann::json report;
+    report["frames_count"] = m_frames_count;
+    report["width"] = m_renderer.get_width();
+    report["height"] = m_renderer.get_height();
+    report["raster_mode"] = m_renderer.get_raster_mode() == Renderer::RasterMode::HalfSpace ? "half-space" : "scanline";
+    report["shading_mode"] = m_renderer.get_shading_mode() == Renderer::ShadingMode::Deferred ? "deferred" : "forward";
+    report["texture_filter"] = m_renderer.get_texture_filter() == MipChain::Filter::Trilinear ? "trilinear"
+        : m_renderer.get_texture_filter() == MipChain::Filter::Bilinear ? "bilinear" 
+        : "nearest";
+    report["texture_compression"] = m_renderer.get_texture_compression();
+    report["total"] = get_stage_times(total);
+    report["total"]["upload_ms"] = total_upload_time;
+    report["total"]["frame_ms"] = total_frame_time;
+    report["average_fps"] = total_frame_time > 0 ? 1000.0f * m_timings.size() / total_frame_time : 0.0f;
+    report["frames"] = frames;
+
+    std::ofstream output(m_output_path);
+    if (!output) {
+        std::cerr << "Failed to open " << m_output_path << '\n';
+        return false;
+    }
+    output << report.dump(REPORT_INDENT) << '\n';
+    std::cout << "Report written to " << m_output_path << '\n';
+    return true;
+}
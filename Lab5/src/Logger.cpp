@@ -31,6 +31,14 @@ void Logger::set_camera(std::shared_ptr<Camera> camera) {
     m_camera = camera;
 }
 
+void Logger::set_render_stats(const Renderer::Stats& stats) {
+    m_stats = stats;
+}
+
+void Logger::set_render_modes(std::string modes) {
+    m_modes = std::move(modes);
+}
+
 void Logger::draw(sf::RenderWindow& window) const {
     window.draw(m_text);
 }
@@ -47,12 +55,28 @@ void Logger::update() {
         "Eye = [{:.2f}, {:.2f}, {:.2f}]\n"
         "target = [{:.2f}, {:.2f}, {:.2f}]\n"
         "up = [{:.2f}, {:.2f}, {:.2f}]\n"
-        "Scale = {:.2f}",
+        "Scale = {:.2f}\n"
+        "Resolution = {}x{}\n"
+        "Triangles = {} / {}\n"
+        "Culled: back = {}, offscreen = {}, degenerate = {}, frustum = {}\n"
+        "Clipped = {}\n"
+        "HiZ rejected: blocks = {} / {}, triangles = {}\n"
+        "Blocks: cleared = {}, resolved = {}\n"
+        "{}",
         fps, 
         eye.x, eye.y, eye.z,
         target.x, target.y, target.z,
         up.x, up.y, up.z,
-        scale
+        scale,
+        m_stats.width, m_stats.height,
+        m_stats.submitted, m_stats.faces,
+        m_stats.culled_backface, m_stats.culled_offscreen, 
+        m_stats.culled_degenerate, m_stats.culled_frustum,
+        m_stats.clipped,
+        m_stats.hiz_rejected_blocks, m_stats.hiz_tested_blocks,
+        m_stats.hiz_rejected_triangles,
+        m_stats.cleared_blocks, m_stats.resolved_blocks,
+        m_modes
     );
 
     m_text.setString(text_str);
@@ -13,26 +13,66 @@ constexpr float KEYBOARD_SENSITIVITY{0.1};
 constexpr int WIDTH{1600};
 constexpr int HEIGHT{900};
 constexpr int MAX_FPS{144};
+constexpr float TARGET_FPS{60};
+constexpr int CHANNELS{4};
 
+// The brackets divide or multiply the error bound of the specular power by the step
+constexpr float MIN_SPECULAR_ERROR{1e-6f};
+constexpr float MAX_SPECULAR_ERROR{1e-1f};
+constexpr float SPECULAR_ERROR_STEP{10.0f};
+
+using SpecularMode = Raster::SpecularMode;
+using Filter = MipChain::Filter;
+
+constexpr std::array<std::pair<SpecularMode, const char*>, 4> SPECULAR_MODES = {{
+    {SpecularMode::Off,      "off"},
+    {SpecularMode::Exact,    "exact"},
+    {SpecularMode::Table,    "table"},
+    {SpecularMode::Squaring, "squaring"}
+}};
+
+constexpr std::array<std::pair<Filter, const char*>, 3> TEXTURE_FILTERS = {{
+    {Filter::Nearest,   "nearest"},
+    {Filter::Bilinear,  "bilinear"},
+    {Filter::Trilinear, "trilinear"}
+}};
+
+// Index of the value in a table of value and name pairs
+template<typename T, size_t N>
+size_t find_index(const std::array<std::pair<T, const char*>, N>& table, T value) {
+    return std::ranges::find(table, value, &std::pair<T, const char*>::first) - table.begin();
+}
+
+const char* on_off(bool enabled) {
+    return enabled ? "on" : "off";
 }
 
-MainForm::MainForm() noexcept
+}
+
+MainForm::MainForm(bool texture_compression) noexcept
     : m_window(sf::VideoMode(WIDTH, HEIGHT), "Lab 5")
+    , m_renderer(texture_compression)
     , m_camera(std::make_shared<Camera>())
     , m_counter(std::make_shared<FPSCounter>())
     , m_center(WIDTH / 2, HEIGHT / 2)
+    , m_resolution(WIDTH, HEIGHT, TARGET_FPS)
 { 
     m_window.setMouseCursorVisible(false);
     m_window.setFramerateLimit(MAX_FPS);
     m_texture.create(WIDTH, HEIGHT);
+    m_texture.setSmooth(true);
     m_renderer.set_camera(m_camera);
     m_logger.set_camera(m_camera);
     m_logger.set_fps_counter(m_counter);
 }
 
 void MainForm::run_main_loop() {
+    // Frames keep loading while the first ones are shown
+    const auto show_progress = [this](int loaded, int total) {
+        m_window.setTitle(loaded < total ? std::format("Lab 5 - loading frames {}/{}", loaded, total) : "Lab 5"s);
+    };
     if (!m_logger.initialize() ||
-        !m_scene.initialize()) {
+        !m_scene.initialize(show_progress)) {
         return;
     }
 
@@ -89,11 +129,21 @@ void MainForm::draw() {
     const auto& faces = m_scene.get_faces();
     const auto& normals = m_scene.get_normals();
     const auto& texture_vertices = m_scene.get_texture_vertices();
-    const auto& mtls = m_scene.get_mtls();
+    const auto& material_ids = m_scene.get_material_ids();
     m_scene.update();
+
+    m_resolution.update(m_delta_time);
+    m_renderer.set_resolution(m_resolution.get_width(), m_resolution.get_height());
     
-    m_renderer.draw(vertices, faces, normals, texture_vertices, mtls);
-    m_texture.update(m_renderer.data());
+    m_renderer.draw(vertices, faces, normals, texture_vertices, material_ids);
+
+    // The frame is rendered into the top left corner of the texture and stretched to the window
+    const int width = m_renderer.get_width();
+    const int height = m_renderer.get_height();
+    m_texture.update(m_renderer.data(), width, height, 0, 0);
+    pad_frame(m_renderer.data(), width, height);
+    sprite.setTextureRect(sf::IntRect(0, 0, width, height));
+    sprite.setScale(static_cast<float>(WIDTH) / width, static_cast<float>(HEIGHT) / height);
 
     m_window.clear();
     m_window.draw(sprite);
@@ -101,9 +151,28 @@ void MainForm::draw() {
     m_window.display();
 
     m_counter->update();
+    m_logger.set_render_stats(m_renderer.get_stats());
+    m_logger.set_render_modes(get_render_modes());
     m_logger.update();
 }
 
+void MainForm::pad_frame(const uint8_t* pixels, int width, int height) {
+    const int padded_width = std::min(width + 1, WIDTH);
+    const int padded_height = std::min(height + 1, HEIGHT);
+
+    if (padded_width > width) {
+        m_edge.resize(padded_height * CHANNELS);
+        for (int y = 0; y < padded_height; ++y) {
+            const int row = std::min(y, height - 1);
+            std::copy_n(pixels + ((row + 1) * width - 1) * CHANNELS, CHANNELS, m_edge.begin() + y * CHANNELS);
+        }
+        m_texture.update(m_edge.data(), 1, padded_height, width, 0);
+    }
+    if (padded_height > height) {
+        m_texture.update(pixels + (height - 1) * width * CHANNELS, width, 1, 0, height);
+    }
+}
+
 void MainForm::handle_mouse() {
     sf::Vector2i mouse_position = sf::Mouse::getPosition(m_window);
 
@@ -176,5 +245,76 @@ void MainForm::on_key_press(sf::Keyboard::Key code) {
         case sf::Keyboard::Q:
             // m_window.close();
             break;
+
+        case sf::Keyboard::R: {
+            const bool half_space = m_renderer.get_raster_mode() == Renderer::RasterMode::Scanline;
+            m_renderer.set_raster_mode(half_space 
+                ? Renderer::RasterMode::HalfSpace 
+                : Renderer::RasterMode::Scanline);
+            break;
+        }
+
+        case sf::Keyboard::V: {
+            const bool deferred = m_renderer.get_shading_mode() == Renderer::ShadingMode::Forward;
+            m_renderer.set_shading_mode(deferred 
+                ? Renderer::ShadingMode::Deferred 
+                : Renderer::ShadingMode::Forward);
+            break;
+        }
+
+        case sf::Keyboard::B: {
+            const bool enabled = !m_renderer.get_backface_culling();
+            m_renderer.set_backface_culling(enabled);
+            break;
+        }
+
+        case sf::Keyboard::H: {
+            const bool enabled = !m_renderer.get_hierarchical_z();
+            m_renderer.set_hierarchical_z(enabled);
+            break;
+        }
+
+        case sf::Keyboard::P: {
+            const size_t current = find_index(SPECULAR_MODES, m_renderer.get_specular_mode());
+            m_renderer.set_specular_mode(SPECULAR_MODES[(current + 1) % SPECULAR_MODES.size()].first);
+            break;
+        }
+
+        case sf::Keyboard::LBracket:
+        case sf::Keyboard::RBracket: {
+            const float step = code == sf::Keyboard::LBracket ? 1.0f / SPECULAR_ERROR_STEP : SPECULAR_ERROR_STEP;
+            m_renderer.set_specular_error(std::clamp(m_renderer.get_specular_error() * step, 
+                                                     MIN_SPECULAR_ERROR, MAX_SPECULAR_ERROR));
+            break;
+        }
+
+        case sf::Keyboard::F: {
+            const size_t current = find_index(TEXTURE_FILTERS, m_renderer.get_texture_filter());
+            m_renderer.set_texture_filter(TEXTURE_FILTERS[(current + 1) % TEXTURE_FILTERS.size()].first);
+            break;
+        }
+
+        case sf::Keyboard::T: {
+            const bool enabled = !m_resolution.get_enabled();
+            m_resolution.set_enabled(enabled);
+            break;
+        }
     }
 }
+
+std::string MainForm::get_render_modes() const {
+    const bool half_space = m_renderer.get_raster_mode() == Renderer::RasterMode::HalfSpace;
+    const bool deferred = m_renderer.get_shading_mode() == Renderer::ShadingMode::Deferred;
+    return std::format(
+        "Raster = {}, shading = {}\n"
+        "Backface culling = {}, HiZ = {}, dynamic resolution = {}\n"
+        "Specular = {}, error = {:.0e}, filter = {}, compressed textures = {}",
+        half_space ? "half-space" : "scanline", deferred ? "deferred" : "forward",
+        on_off(m_renderer.get_backface_culling()), on_off(m_renderer.get_hierarchical_z()),
+        on_off(m_resolution.get_enabled()),
+        SPECULAR_MODES[find_index(SPECULAR_MODES, m_renderer.get_specular_mode())].second,
+        m_renderer.get_specular_error(),
+        TEXTURE_FILTERS[find_index(TEXTURE_FILTERS, m_renderer.get_texture_filter())].second,
+        on_off(m_renderer.get_texture_compression())
+    );
+}
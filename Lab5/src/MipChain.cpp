@@ -0,0 +1,309 @@
+#include "MipChain.hpp"
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+
+namespace {
+
+// Rows of a level downsampled by one pool task, smaller levels are done in one task
+constexpr int BAND_ROWS{64};
+
+constexpr uint32_t EVEN_CHANNELS{0x00FF00FF};
+constexpr uint32_t AVERAGE_ROUNDING{0x00020002};
+constexpr uint32_t LERP_ROUNDING{0x00800080};
+
+// Interpolation weights are fixed point with 8 fraction bits
+constexpr int WEIGHT_BITS{8};
+constexpr float WEIGHT_ONE{1 << WEIGHT_BITS};
+
+// Chains are stored as the header, then the size and the blocks or texels of each level.
+// Level data is aligned like Texture2D, so the texels can be read from the mapped file.
+// Version 2 takes the luma of BC4 from the right channels, version 3 adds texels and alignment
+constexpr char FILE_MAGIC[4]{'A', 'K', 'G', 'M'};
+constexpr uint32_t FILE_VERSION{3};
+
+enum class FileFormat : uint32_t {
+    BC1,
+    BC4,
+    Linear,
+    Morton
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t levels;
+};
+
+struct LevelHeader {
+    int32_t width;
+    int32_t height;
+};
+
+size_t align_offset(size_t offset) {
+    return (offset + Texture2D::ALIGNMENT - 1) / Texture2D::ALIGNMENT * Texture2D::ALIGNMENT;
+}
+
+// Rounded mean of four colors, channels are summed in pairs within 16 bit lanes
+uint32_t average(uint32_t c1, uint32_t c2, uint32_t c3, uint32_t c4) {
+    const uint32_t even = (c1 & EVEN_CHANNELS) + (c2 & EVEN_CHANNELS) + 
+                          (c3 & EVEN_CHANNELS) + (c4 & EVEN_CHANNELS);
+    const uint32_t odd = ((c1 >> 8) & EVEN_CHANNELS) + ((c2 >> 8) & EVEN_CHANNELS) + 
+                         ((c3 >> 8) & EVEN_CHANNELS) + ((c4 >> 8) & EVEN_CHANNELS);
+    return (((even + AVERAGE_ROUNDING) >> 2) & EVEN_CHANNELS) | 
+           ((((odd + AVERAGE_ROUNDING) >> 2) & EVEN_CHANNELS) << 8);
+}
+
+uint32_t get_weight(float t) {
+    return static_cast<uint32_t>(t * WEIGHT_ONE + 0.5f);
+}
+
+// Rounded c1 + (c2 - c1) * weight / 256 for all channels, the weighted sums of two 
+// channels fit 16 bit lanes since the weights add up to 256
+uint32_t lerp(uint32_t c1, uint32_t c2, uint32_t weight) {
+    const uint32_t inverse = (1u << WEIGHT_BITS) - weight;
+    const uint32_t even = (c1 & EVEN_CHANNELS) * inverse + (c2 & EVEN_CHANNELS) * weight + LERP_ROUNDING;
+    const uint32_t odd = ((c1 >> 8) & EVEN_CHANNELS) * inverse + ((c2 >> 8) & EVEN_CHANNELS) * weight + LERP_ROUNDING;
+    return ((even >> WEIGHT_BITS) & EVEN_CHANNELS) | (((odd >> WEIGHT_BITS) & EVEN_CHANNELS) << 8);
+}
+
+template <typename Level>
+uint32_t point_sample(const Level& texture, float u, float v) {
+    u = std::clamp(u, 0.0f, 1.0f);
+    v = 1.0f - std::clamp(v, 0.0f, 1.0f);
+
+    const int x = std::clamp(static_cast<int>(u * texture.get_width()), 0, texture.get_width() - 1);
+    const int y = std::clamp(static_cast<int>(v * texture.get_height()), 0, texture.get_height() - 1);
+    return texture.get(x, y);
+}
+
+// Texel centers are at half-integer coordinates, samples past the edges clamp to it
+template <typename Level>
+uint32_t bilinear_sample(const Level& texture, float u, float v) {
+    u = std::clamp(u, 0.0f, 1.0f);
+    v = 1.0f - std::clamp(v, 0.0f, 1.0f);
+
+    // Coordinates are at least -0.5, so truncation after a shift by one is the floor
+    const float fx = u * texture.get_width() + 0.5f;
+    const float fy = v * texture.get_height() + 0.5f;
+    const int floor_x = static_cast<int>(fx) - 1;
+    const int floor_y = static_cast<int>(fy) - 1;
+    const float tx = fx - static_cast<float>(floor_x + 1);
+    const float ty = fy - static_cast<float>(floor_y + 1);
+
+    const int x0 = std::clamp(floor_x, 0, texture.get_width() - 1);
+    const int y0 = std::clamp(floor_y, 0, texture.get_height() - 1);
+    const int x1 = std::min(floor_x + 1, texture.get_width() - 1);
+    const int y1 = std::min(floor_y + 1, texture.get_height() - 1);
+
+    const uint32_t weight_x = get_weight(tx);
+    return lerp(lerp(texture.get(x0, y0), texture.get(x1, y0), weight_x), 
+                lerp(texture.get(x0, y1), texture.get(x1, y1), weight_x), 
+                get_weight(ty));
+}
+}
+
+MipChain::MipChain(Texture2D base) {
+    m_levels.push_back(std::move(base));
+    build_levels(nullptr);
+}
+
+MipChain::MipChain(Texture2D base, ThreadPool& pool) {
+    m_levels.push_back(std::move(base));
+    build_levels(&pool);
+}
+
+void MipChain::compress(BlockTexture::Format format) {
+    m_compressed.clear();
+    for (const Texture2D& level : m_levels) {
+        m_compressed.push_back(BlockTexture::compress(level, format));
+    }
+    m_levels.clear();
+}
+
+void MipChain::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.format = static_cast<uint32_t>(is_compressed() 
+        ? (m_compressed.front().get_format() == BlockTexture::Format::BC4 ? FileFormat::BC4 : FileFormat::BC1)
+        : (m_levels.front().get_layout() == Texture2D::Layout::Morton ? FileFormat::Morton : FileFormat::Linear));
+    header.levels = static_cast<uint32_t>(get_levels_count());
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    size_t offset = sizeof(header);
+
+    const auto write_level = [&](int width, int height, const void* data, size_t size) {
+        const LevelHeader level_header{width, height};
+        file.write(reinterpret_cast<const char*>(&level_header), sizeof(level_header));
+        offset += sizeof(level_header);
+
+        const char padding[Texture2D::ALIGNMENT]{};
+        file.write(padding, static_cast<std::streamsize>(align_offset(offset) - offset));
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        offset = align_offset(offset) + size;
+    };
+
+    for (const BlockTexture& level : m_compressed) {
+        write_level(level.get_width(), level.get_height(), level.data(), level.size());
+    }
+    for (const Texture2D& level : m_levels) {
+        write_level(level.get_width(), level.get_height(), level.data(), level.size() * sizeof(uint32_t));
+    }
+
+    if (!file) {
+        throw std::runtime_error("Failed to write texture: " + filename);
+    }
+}
+
+MipChain MipChain::load(const std::string& filename) {
+    MipChain chain;
+    chain.m_file = MappedFile(filename);
+    const uint8_t* begin = chain.m_file.data();
+    const uint8_t* data = begin;
+    const uint8_t* end = begin + chain.m_file.size();
+
+    FileHeader header;
+    if (chain.m_file.size() < sizeof(header)) {
+        throw std::runtime_error("Unexpected end of file in texture: " + filename);
+    }
+    std::memcpy(&header, data, sizeof(header));
+    data += sizeof(header);
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION ||
+        header.format > static_cast<uint32_t>(FileFormat::Morton)) {
+        throw std::runtime_error("Unsupported texture file: " + filename);
+    }
+
+    const auto format = static_cast<FileFormat>(header.format);
+    const bool compressed = format == FileFormat::BC1 || format == FileFormat::BC4;
+    const auto layout = format == FileFormat::Morton ? Texture2D::Layout::Morton : Texture2D::Layout::Linear;
+
+    for (uint32_t i = 0; i < header.levels; ++i) {
+        LevelHeader level;
+        if (static_cast<size_t>(end - data) < sizeof(level)) {
+            throw std::runtime_error("Unexpected end of file in texture: " + filename);
+        }
+        std::memcpy(&level, data, sizeof(level));
+        data += sizeof(level);
+
+        if (level.width <= 0 || level.height <= 0) {
+            throw std::runtime_error("Invalid level size in texture: " + filename);
+        }
+        const size_t size = compressed 
+            ? BlockTexture::get_blocks_size(level.width, level.height) 
+            : Texture2D::get_size(level.width, level.height, layout) * sizeof(uint32_t);
+        data = begin + std::min(align_offset(data - begin), static_cast<size_t>(end - begin));
+        if (static_cast<size_t>(end - data) < size) {
+            throw std::runtime_error("Unexpected end of file in texture: " + filename);
+        }
+
+        if (compressed) {
+            chain.m_compressed.push_back(BlockTexture::view(level.width, level.height, 
+                format == FileFormat::BC4 ? BlockTexture::Format::BC4 : BlockTexture::Format::BC1, data));
+        } else {
+            chain.m_levels.push_back(Texture2D::view(level.width, level.height, layout, 
+                                                     reinterpret_cast<const uint32_t*>(data)));
+        }
+        data += size;
+    }
+
+    const int last = chain.get_levels_count() - 1;
+    const bool complete = last >= 0 && (compressed 
+        ? chain.m_compressed[last].get_width() == 1 && chain.m_compressed[last].get_height() == 1
+        : chain.m_levels[last].get_width() == 1 && chain.m_levels[last].get_height() == 1);
+    if (!complete) {
+        throw std::runtime_error("Incomplete mip chain in texture: " + filename);
+    }
+    return chain;
+}
+
+void MipChain::build_levels(ThreadPool* pool) {
+    while (m_levels.back().get_width() > 1 || m_levels.back().get_height() > 1) {
+        const Texture2D& source = m_levels.back();
+        Texture2D target(std::max(1, source.get_width() / 2), 
+                         std::max(1, source.get_height() / 2), 
+                         source.get_layout());
+
+        // Without a pool the calling thread takes all rows, otherwise only the first band
+        const int first_rows = pool ? std::min(BAND_ROWS, target.get_height()) : target.get_height();
+        std::vector<std::future<std::any>> futures;
+        for (int y = first_rows; y < target.get_height(); y += BAND_ROWS) {
+            const int y1 = std::min(y + BAND_ROWS, target.get_height());
+            futures.emplace_back(pool->add_task([&source, &target, y, y1] { 
+                downsample_rows(source, target, y, y1); 
+            }));
+        }
+        downsample_rows(source, target, 0, first_rows);
+        std::ranges::for_each(futures, [](auto& future) { future.get(); });
+
+        m_levels.push_back(std::move(target));
+    }
+}
+
+// Odd sizes repeat the last row or column of the source
+void MipChain::downsample_rows(const Texture2D& source, Texture2D& target, int y0, int y1) {
+    const int max_x = source.get_width() - 1;
+    const int max_y = source.get_height() - 1;
+
+    for (int y = y0; y < y1; ++y) {
+        const int sy0 = std::min(2 * y, max_y);
+        const int sy1 = std::min(2 * y + 1, max_y);
+        for (int x = 0; x < target.get_width(); ++x) {
+            const int sx0 = std::min(2 * x, max_x);
+            const int sx1 = std::min(2 * x + 1, max_x);
+            target.set(x, y, average(source.get(sx0, sy0), source.get(sx1, sy0), 
+                                     source.get(sx0, sy1), source.get(sx1, sy1)));
+        }
+    }
+}
+
+uint32_t MipChain::sample(float u, float v, float lod, Filter filter) const {
+    switch (filter) {
+        case Filter::Bilinear: 
+            return sample_bilinear(u, v, get_level_index(lod));
+
+        case Filter::Trilinear: {
+            lod = std::clamp(lod, 0.0f, static_cast<float>(get_levels_count() - 1));
+            const int level = static_cast<int>(lod);
+            const float t = lod - level;
+            const uint32_t color = sample_bilinear(u, v, level);
+            const uint32_t weight = get_weight(t);
+            return weight > 0 ? lerp(color, sample_bilinear(u, v, level + 1), weight) : color;
+        }
+
+        default: 
+            return sample_nearest(u, v, get_level_index(lod));
+    }
+}
+
+uint32_t MipChain::sample_nearest(float u, float v, int level) const {
+    return is_compressed() ? point_sample(m_compressed[level], u, v) : point_sample(m_levels[level], u, v);
+}
+
+uint32_t MipChain::sample_bilinear(float u, float v, int level) const {
+    return is_compressed() ? bilinear_sample(m_compressed[level], u, v) : bilinear_sample(m_levels[level], u, v);
+}
+
+int MipChain::get_level_index(float lod) const {
+    return std::clamp(static_cast<int>(lod + 0.5f), 0, get_levels_count() - 1);
+}
+
+const Texture2D& MipChain::get_level(int level) const {
+    return m_levels[level];
+}
+
+const BlockTexture& MipChain::get_compressed_level(int level) const {
+    return m_compressed[level];
+}
+
+int MipChain::get_levels_count() const {
+    return static_cast<int>(is_compressed() ? m_compressed.size() : m_levels.size());
+}
+
+bool MipChain::is_compressed() const {
+    return !m_compressed.empty();
+}
@@ -1,10 +1,249 @@
 #include <Parser.hpp>
+#include "MappedFile.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
-#include <nlohmann/json.hpp>
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
 
 using namespace std::string_literals;
 
+namespace {
+
+// Smaller files are not worth splitting into chunks
+constexpr size_t MIN_CHUNK_SIZE{1 << 20};
+
+constexpr auto CACHE_EXTENSION = ".mesh";
+
+// Mesh caches are stored as the header, then each section of records at an offset 
+// aligned to a cache line. The version changes whenever parsing does
+constexpr char FILE_MAGIC[4]{'A', 'K', 'G', 'O'};
+constexpr uint32_t FILE_VERSION{1};
+constexpr size_t SECTION_ALIGNMENT{64};
+
+enum Section {
+    VERTICES,
+    NORMALS,
+    TEXTURE_VERTICES,
+    FACES,
+    MATERIAL_IDS,
+    SECTIONS_COUNT
+};
+
+struct SectionHeader {
+    uint64_t offset;
+    uint64_t count;
+    uint64_t element_size;
+};
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t source_hash;
+    SectionHeader sections[SECTIONS_COUNT];
+};
+
+constexpr uint64_t HASH_BASIS{0xCBF29CE484222325};
+constexpr uint64_t HASH_PRIME{0x100000001B3};
+
+// FNV-1a over 8 byte words and then the remaining bytes, the size is mixed in last 
+// so that files differing only in trailing zeros do not match
+uint64_t get_hash(const uint8_t* data, size_t size) {
+    uint64_t hash = HASH_BASIS;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * HASH_PRIME;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ data[i]) * HASH_PRIME;
+    }
+    return (hash ^ size) * HASH_PRIME;
+}
+
+size_t align_offset(size_t offset) {
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+template <typename T>
+void read_section(const MappedFile& file, const SectionHeader& section, std::vector<T>& records, 
+                  const std::string& filename) 
+{
+    if (section.element_size != sizeof(T) || section.offset % SECTION_ALIGNMENT != 0 || 
+        section.offset > file.size() || section.count > (file.size() - section.offset) / sizeof(T)) 
+    {
+        throw std::runtime_error("Invalid section in mesh cache: " + filename);
+    }
+    records.resize(section.count);
+    std::memcpy(records.data(), file.data() + section.offset, section.count * sizeof(T));
+}
+
+// Fields are separated the way std::istream separates them, lines end at '\n'
+bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+const char* skip_blanks(const char* position, const char* end) {
+    while (position < end && is_blank(*position)) {
+        ++position;
+    }
+    return position;
+}
+
+// Next run of non-blank characters, empty at the end of the line
+std::string_view read_token(const char*& position, const char* end) {
+    const char* begin = skip_blanks(position, end);
+    position = begin;
+    while (position < end && !is_blank(*position)) {
+        ++position;
+    }
+    return {begin, static_cast<size_t>(position - begin)};
+}
+
+// Same result as operator>> of std::istream on well-formed numbers, 
+// which accepts a leading plus that std::from_chars does not
+template <typename T>
+bool read_number(const char*& position, const char* end, T& value) {
+    position = skip_blanks(position, end);
+    const char* begin = position < end && *position == '+' ? position + 1 : position;
+    const auto [next, error] = std::from_chars(begin, end, value);
+    if (error != std::errc{}) {
+        return false;
+    }
+    position = next;
+    return true;
+}
+
+// Leading integer of the text like std::stoi, which throws when there is none
+int read_index(std::string_view text) {
+    const char* begin = text.data() + (text.starts_with('+') ? 1 : 0);
+    int value = 0;
+    const auto [next, error] = std::from_chars(begin, text.data() + text.size(), value);
+    if (error == std::errc::invalid_argument) {
+        throw std::invalid_argument("stoi");
+    }
+    if (error == std::errc::result_out_of_range) {
+        throw std::out_of_range("stoi");
+    }
+    return value;
+}
+
+// Position, texture and normal indices of a v/vt/vn group made zero based, 
+// missing ones become -1
+std::array<uint32_t, 3> read_face_vertex(std::string_view vertex_data) {
+    std::array<uint32_t, 3> indices{};
+    for (uint32_t& index : indices) {
+        const size_t slash = vertex_data.find('/');
+        const std::string_view part = vertex_data.substr(0, slash);
+        const uint32_t value = part.empty() ? 0 : static_cast<uint32_t>(read_index(part));
+        index = value != 0 ? value - 1 : static_cast<uint32_t>(-1);
+
+        if (slash == std::string_view::npos) {
+            vertex_data = {};
+        } else {
+            vertex_data.remove_prefix(slash + 1);
+        }
+    }
+    return indices;
+}
+
+
+// Records of a run of whole lines. Until the usemtl lines of the earlier runs are added 
+// to them, material ids hold the number of usemtl lines of the run before each face
+struct Chunk {
+    Vertices vertices;
+    Faces faces;
+    Vertices normals;
+    TextureVertices texture_vertices;
+    MaterialIds material_ids;
+    uint32_t materials{};
+};
+
+void parse_chunk(const char* position, const char* end, Chunk& chunk) {
+    while (position < end) {
+        const char* line_end = static_cast<const char*>(std::memchr(position, '\n', end - position));
+        if (!line_end) {
+            line_end = end;
+        }
+        const std::string_view type = read_token(position, line_end);
+
+        if (type == "v") {
+            glm::vec4 vertex{0, 0, 0, 1};
+            read_number(position, line_end, vertex.x) && read_number(position, line_end, vertex.y) && 
+                read_number(position, line_end, vertex.z);
+            chunk.vertices.push_back(vertex);
+        } 
+        else if (type == "f") {
+            // Polygons are split into a fan around the first vertex
+            std::array<uint32_t, 3> first{};
+            std::array<uint32_t, 3> previous{};
+            int count = 0;
+            for (auto vertex_data = read_token(position, line_end); !vertex_data.empty(); 
+                 vertex_data = read_token(position, line_end)) 
+            {
+                const std::array<uint32_t, 3> current = read_face_vertex(vertex_data);
+                if (count == 0) {
+                    first = current;
+                } else if (count >= 2) {
+                    chunk.faces.push_back(Face{first, previous, current});
+                    chunk.material_ids.push_back(chunk.materials);
+                }
+                previous = current;
+                count++;
+            }
+        }
+        else if (type == "vn") {
+            glm::vec3 normal{0, 0, 0};
+            read_number(position, line_end, normal.x) && read_number(position, line_end, normal.y) && 
+                read_number(position, line_end, normal.z);
+            chunk.normals.push_back(normal);
+        }
+        else if (type == "vt") {
+            glm::vec2 texture_vertex{};
+            read_number(position, line_end, texture_vertex.x) && read_number(position, line_end, texture_vertex.y);
+            chunk.texture_vertices.push_back(texture_vertex);
+        }
+        else if (type == "usemtl") {
+            chunk.materials++;
+        }
+
+        position = line_end + 1;
+    }
+}
+
+// Faces before the first usemtl share the material of the first one
+uint32_t get_material_id(uint32_t materials) {
+    return std::max(materials, 1u) - 1;
+}
+
+// Runs the task for indices from 0 to count, the first on the calling thread. All of them 
+// finish before an exception is passed on, since they refer to locals of the caller
+template <typename F>
+void run_tasks(ThreadPool& pool, size_t count, const F& task) {
+    std::vector<std::future<std::any>> futures;
+    for (size_t i = 1; i < count; ++i) {
+        futures.emplace_back(pool.add_task([&task, i] { task(i); }));
+    }
+
+    std::exception_ptr error;
+    try {
+        task(0);
+    } catch (...) {
+        error = std::current_exception();
+    }
+    std::ranges::for_each(futures, [](auto& future) { future.wait(); });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    std::ranges::for_each(futures, [](auto& future) { future.get(); });
+}
+}
+
 std::unique_ptr<Parser> Parser::create_parser(const std::string& format){
     std::unique_ptr<Parser> parser{};
     if (format == "obj"){
@@ -13,24 +252,44 @@ std::unique_ptr<Parser> Parser::create_parser(const std::string& format){
     return parser;
 }
 
-Vertices Parser::get_vertices() const {
+Vertices Parser::get_vertices() const& {
     return m_vertices;
 }
 
-Faces Parser::get_faces() const {
+Vertices Parser::get_vertices() && {
+    return std::move(m_vertices);
+}
+
+Faces Parser::get_faces() const& {
     return m_faces;
 }
 
-Vertices Parser::get_normals() const {
+Faces Parser::get_faces() && {
+    return std::move(m_faces);
+}
+
+Vertices Parser::get_normals() const& {
     return m_normals;
 }
 
-TextureVertices Parser::get_texture_vertices() const {
+Vertices Parser::get_normals() && {
+    return std::move(m_normals);
+}
+
+TextureVertices Parser::get_texture_vertices() const& {
     return m_texture_vertices;
 }
 
-Mtls Parser::get_mtls() const {
-    return m_mtls;
+TextureVertices Parser::get_texture_vertices() && {
+    return std::move(m_texture_vertices);
+}
+
+MaterialIds Parser::get_material_ids() const& {
+    return m_material_ids;
+}
+
+MaterialIds Parser::get_material_ids() && {
+    return std::move(m_material_ids);
 }
 
 std::string Parser::get_format(const std::string& path) {
@@ -41,91 +300,183 @@ std::string Parser::get_format(const std::string& path) {
     return path.substr(dot_index + 1);
 }
 
-void ParserOBJ::parse_file(const std::string& file_path) {
-    std::ifstream file(file_path);
-    if (!file.is_open()) { return; }
+void Parser::save(const std::string& filename, uint64_t source_hash) const {
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.version = FILE_VERSION;
+    header.source_hash = source_hash;
 
-    m_faces.clear();
-    m_vertices.clear();
-    m_normals.clear();
-    m_texture_vertices.clear();
-    m_mtls.clear();
+    size_t offset = sizeof(header);
+    auto add_section = [&](Section section, const auto& records) {
+        header.sections[section] = {align_offset(offset), records.size(), sizeof(records[0])};
+        offset = header.sections[section].offset + records.size() * sizeof(records[0]);
+    };
+    add_section(VERTICES, m_vertices);
+    add_section(NORMALS, m_normals);
+    add_section(TEXTURE_VERTICES, m_texture_vertices);
+    add_section(FACES, m_faces);
+    add_section(MATERIAL_IDS, m_material_ids);
 
-    std::string line;
-    int index = 0;
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
 
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string type;
-        iss >> type;
+    offset = sizeof(header);
+    auto write_section = [&](Section section, const auto& records) {
+        const std::string padding(header.sections[section].offset - offset, '\0');
+        file.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+        file.write(reinterpret_cast<const char*>(records.data()), 
+                   static_cast<std::streamsize>(records.size() * sizeof(records[0])));
+        offset = header.sections[section].offset + records.size() * sizeof(records[0]);
+    };
+    write_section(VERTICES, m_vertices);
+    write_section(NORMALS, m_normals);
+    write_section(TEXTURE_VERTICES, m_texture_vertices);
+    write_section(FACES, m_faces);
+    write_section(MATERIAL_IDS, m_material_ids);
 
-        if (type == "v") {
-            glm::vec4 vertex{0, 0, 0, 1};
-            iss >> vertex.x >> vertex.y >> vertex.z;
-            m_vertices.push_back(vertex);
-        } 
-        else if (type == "f") {
-            index++;
-            std::vector<std::array<uint32_t, 3>> face_vertices;
-            std::string vertex_data;
-            
-            while (iss >> vertex_data) {
-                std::vector<std::string> parts;
-                size_t start = 0;
-                size_t end = vertex_data.find('/');
-                
-                while (true) {
-                    parts.push_back(vertex_data.substr(start, end - start));
-                    if (end == std::string::npos) break;
-                    start = end + 1;
-                    end = vertex_data.find('/', start);
-                }
+    if (!file) {
+        throw std::runtime_error("Failed to write mesh cache: " + filename);
+    }
+}
+
+bool Parser::load(const std::string& filename, uint64_t source_hash) {
+    const MappedFile file(filename);
+
+    FileHeader header;
+    if (file.size() < sizeof(header)) {
+        throw std::runtime_error("Unexpected end of file in mesh cache: " + filename);
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.version != FILE_VERSION) {
+        throw std::runtime_error("Unsupported mesh cache: " + filename);
+    }
+    if (header.source_hash != source_hash) {
+        return false;
+    }
+    if (header.sections[MATERIAL_IDS].count != header.sections[FACES].count) {
+        throw std::runtime_error("Invalid section in mesh cache: " + filename);
+    }
 
-                uint32_t v = 0, vt = 0, vn = 0;
+    read_section(file, header.sections[VERTICES], m_vertices, filename);
+    read_section(file, header.sections[NORMALS], m_normals, filename);
+    read_section(file, header.sections[TEXTURE_VERTICES], m_texture_vertices, filename);
+    read_section(file, header.sections[FACES], m_faces, filename);
+    read_section(file, header.sections[MATERIAL_IDS], m_material_ids, filename);
+    return true;
+}
 
-                if (!parts[0].empty())
-                    v = std::stoi(parts[0]);
-                if (parts.size() > 1 && !parts[1].empty())
-                    vt = std::stoi(parts[1]);
-                if (parts.size() > 2 && !parts[2].empty())
-                    vn = std::stoi(parts[2]);
+void ParserOBJ::set_threads_count(int threads_count) {
+    m_threads_count = std::max(threads_count, 1);
+    m_pool = m_threads_count > 1 ? std::make_unique<ThreadPool>(m_threads_count - 1) : nullptr;
+}
 
-                v = (v != 0) ? v - 1 : -1;
-                vt = (vt != 0) ? vt - 1 : -1;
-                vn = (vn != 0) ? vn - 1 : -1;
+void ParserOBJ::set_cache_enabled(bool enabled) {
+    m_cache_enabled = enabled;
+}
 
-                face_vertices.push_back({v, vt, vn});
-            }
+void ParserOBJ::parse_file(const std::string& file_path) {
+    MappedFile file;
+    try {
+        file = MappedFile(file_path);
+    } catch (const std::runtime_error&) {
+        return;
+    }
 
-            size_t num_verts = face_vertices.size();
-            if (num_verts < 3) continue;
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    if (!m_cache_enabled) {
+        parse_text(begin, begin + file.size());
+        return;
+    }
 
-            for (size_t i = 1; i < num_verts - 1; ++i) {
-                Face face;
-                face[0] = face_vertices[0];
-                face[1] = face_vertices[i];
-                face[2] = face_vertices[i + 1];
-                m_faces.push_back(face);
+    // The cache is written for the first parse and again whenever the content changes
+    const std::string cache = file_path + CACHE_EXTENSION;
+    const uint64_t source_hash = get_hash(file.data(), file.size());
+    std::error_code error;
+    if (std::filesystem::exists(cache, error)) {
+        try {
+            if (load(cache, source_hash)) {
+                return;
             }
+        } catch (const std::exception& e) {
+            std::cerr << "Mesh cache error: " << e.what() << std::endl;
         }
-        else if (type == "vn") {
-            glm::vec3 normal{0, 0, 0};
-            iss >> normal.x >> normal.y >> normal.z;
-            m_normals.push_back(normal);
-        }
-        else if (type == "vt") {
-            glm::vec2 texture_vertex{};
-            iss >> texture_vertex.x >> texture_vertex.y;
-            m_texture_vertices.push_back(texture_vertex);
-        }
-        else if (type == "usemtl") {
-            m_mtls.push_back(index);
-            index = 0;
-        }
     }
 
-    for (int i = 0; i < m_mtls.size() - 1; ++i){
-        m_mtls[i] = m_mtls[i + 1];
+    parse_text(begin, begin + file.size());
+    try {
+        save(cache, source_hash);
+    } catch (const std::exception& e) {
+        std::cerr << "Mesh cache error: " << e.what() << std::endl;
+    }
+}
+
+void ParserOBJ::parse_text(const char* begin, const char* end) {
+    const size_t size = static_cast<size_t>(end - begin);
+    const size_t chunks_count = std::min(static_cast<size_t>(m_threads_count), size / MIN_CHUNK_SIZE);
+
+    if (chunks_count <= 1) {
+        Chunk chunk;
+        parse_chunk(begin, end, chunk);
+        std::ranges::transform(chunk.material_ids, chunk.material_ids.begin(), get_material_id);
+
+        m_vertices = std::move(chunk.vertices);
+        m_faces = std::move(chunk.faces);
+        m_normals = std::move(chunk.normals);
+        m_texture_vertices = std::move(chunk.texture_vertices);
+        m_material_ids = std::move(chunk.material_ids);
+        return;
     }
-    m_mtls[m_mtls.size() - 1] = INT_MAX;
+
+    // Chunks of about equal size, each bound moved past the end of the line it falls into
+    std::vector<const char*> bounds{begin};
+    for (size_t i = 1; i < chunks_count; ++i) {
+        const char* bound = std::max(begin + size * i / chunks_count, bounds.back());
+        const char* line_end = static_cast<const char*>(std::memchr(bound, '\n', end - bound));
+        bounds.push_back(line_end ? line_end + 1 : end);
+    }
+    bounds.push_back(end);
+
+    std::vector<Chunk> chunks(chunks_count);
+    run_tasks(*m_pool, chunks_count, [&](size_t i) {
+        parse_chunk(bounds[i], bounds[i + 1], chunks[i]);
+    });
+
+    // Face indices in the file are already global, only the places of the records of each 
+    // chunk and the usemtl lines before it come from the counts of the earlier chunks
+    struct Offsets {
+        size_t vertices;
+        size_t faces;
+        size_t normals;
+        size_t texture_vertices;
+        uint32_t materials;
+    };
+    std::vector<Offsets> offsets(chunks_count + 1);
+    for (size_t i = 0; i < chunks_count; ++i) {
+        offsets[i + 1] = {
+            offsets[i].vertices + chunks[i].vertices.size(),
+            offsets[i].faces + chunks[i].faces.size(),
+            offsets[i].normals + chunks[i].normals.size(),
+            offsets[i].texture_vertices + chunks[i].texture_vertices.size(),
+            offsets[i].materials + chunks[i].materials
+        };
+    }
+
+    const Offsets& total = offsets.back();
+    m_vertices.resize(total.vertices);
+    m_faces.resize(total.faces);
+    m_normals.resize(total.normals);
+    m_texture_vertices.resize(total.texture_vertices);
+    m_material_ids.resize(total.faces);
+
+    run_tasks(*m_pool, chunks_count, [&](size_t i) {
+        const Chunk& chunk = chunks[i];
+        const Offsets& offset = offsets[i];
+        std::ranges::copy(chunk.vertices, m_vertices.begin() + offset.vertices);
+        std::ranges::copy(chunk.faces, m_faces.begin() + offset.faces);
+        std::ranges::copy(chunk.normals, m_normals.begin() + offset.normals);
+        std::ranges::copy(chunk.texture_vertices, m_texture_vertices.begin() + offset.texture_vertices);
+        std::ranges::transform(chunk.material_ids, m_material_ids.begin() + offset.faces, [&](uint32_t materials) {
+            return get_material_id(offset.materials + materials);
+        });
+    });
 }
@@ -1,46 +1,35 @@
 #include "Raster.hpp"
+#include "Simd.hpp"
+#include <bit>
 #include <cmath>
-#include <fstream>
+#include <filesystem>
 #include <iostream>
+#include <optional>
 #include <stdexcept>
-#include <iostream>
 
 namespace {
 
-constexpr int NUMBER_TEXTURES = 4;
-constexpr int TEXTURE_WIDTH = 2048;
-constexpr int TEXTURE_HEIGHT = 2048;
-
 constexpr float a = 250.0;
 constexpr float ka = 0.1;
 constexpr float kd = 0.5;
 constexpr float ks = 0.3;
 
-std::vector<std::vector<uint32_t>> load_texture(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        throw std::runtime_error("Failed to open texture file: " + filename);
-    }
-
-    std::vector<std::vector<uint32_t>> texture(TEXTURE_HEIGHT, std::vector<uint32_t>(TEXTURE_WIDTH));
-    std::vector<uint8_t> row_buffer(TEXTURE_WIDTH * 3);
+// Absolute error of the approximated specular power, a fraction of a color step
+constexpr float DEFAULT_SPECULAR_ERROR = 1e-3;
 
-    for (int y = 0; y < TEXTURE_HEIGHT; ++y) {
-        file.read(reinterpret_cast<char*>(row_buffer.data()), TEXTURE_WIDTH * 3);
-        
-        if (file.gcount() != TEXTURE_WIDTH * 3) {
-            throw std::runtime_error("Unexpected end of file in texture: " + filename);
-        }
+// Sampled until the texture is loaded, or for good when it fails to load
+constexpr uint32_t DIFFUSE_PLACEHOLDER = 0xFF808080;
+constexpr uint32_t SPECULAR_PLACEHOLDER = 0xFF000000;
 
-        for (int x = 0; x < TEXTURE_WIDTH; ++x) {
-            uint8_t r = row_buffer[x * 3];
-            uint8_t g = row_buffer[x * 3 + 1];
-            uint8_t b = row_buffer[x * 3 + 2];
-            texture[y][x] = (0xFF << 24) | (b << 16) | (g << 8) | r;
-        }
-    }
+SpecularPower::Mode get_power_mode(Raster::SpecularMode mode) {
+    return mode == Raster::SpecularMode::Table ? SpecularPower::Mode::Table
+        : mode == Raster::SpecularMode::Squaring ? SpecularPower::Mode::Squaring
+        : SpecularPower::Mode::Exact;
+}
 
-    return texture;
+template <typename Level>
+bool has_texture_size(const Level& level) {
+    return level.get_width() == Raster::TEXTURE_WIDTH && level.get_height() == Raster::TEXTURE_HEIGHT;
 }
 
 glm::vec3 normal_from_color(uint32_t color) {
@@ -55,19 +44,312 @@ glm::vec3 normal_from_color(uint32_t color) {
     });
 }
 
-Color::RGBA getPixel(const std::vector<std::vector<uint32_t>>& data, float u, float v) {
-    u = std::clamp(u, 0.0f, 1.0f);
-    v = 1.0f - std::clamp(v, 0.0f, 1.0f);
-    
-    int x = std::clamp((int)(u * TEXTURE_WIDTH), 0, TEXTURE_WIDTH - 1);
-    int y = std::clamp((int)(v * TEXTURE_HEIGHT), 0, TEXTURE_HEIGHT - 1);
-    
-    return static_cast<Color::RGBA>(data[y][x]);
+#ifdef AKG_SIMD_X86
+
+// Batch kernels repeat get_color lane by lane: the doubled normal and the direction to
+// the sun are normalized as 1 / sqrt, the diffuse texel is scaled by kd * NL * 2 clamped
+// to [0, 1], or by ka when the fragment faces away, and channels are rounded half up.
+// Lit fragments add the specular texel scaled by ks * (N·H)^a with saturation.
+// Texels are fetched beforehand, point sampled in SIMD or filtered lane by lane.
+// Inactive lanes get a unit normal so they stay finite, and their colors are not stored
+
+// Inputs of the specular term, the kernels leave it out without them
+struct SpecularInputs {
+    const uint32_t* texels;
+    const glm::vec3& eye;
+    const SpecularPower& power;
+    SpecularPower::Mode mode;
+};
+
+template <typename Level>
+void gather_texels(const Level& data, const int32_t* x, const int32_t* y, uint32_t* texels, int count) {
+    for (int lane = 0; lane < count; ++lane) {
+        texels[lane] = data.get(x[lane], y[lane]);
+    }
+}
+
+AKG_TARGET_AVX2
+void normalize_avx2(__m256& x, __m256& y, __m256& z) {
+    const __m256 length_squared = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z));
+    const __m256 inv_length = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_sqrt_ps(length_squared));
+    x = _mm256_mul_ps(x, inv_length);
+    y = _mm256_mul_ps(y, inv_length);
+    z = _mm256_mul_ps(z, inv_length);
+}
+
+AKG_TARGET_AVX2
+__m256i scale_channel_avx2(__m256i color, __m256 factor, int shift) {
+    const __m256i channel = _mm256_and_si256(_mm256_srli_epi32(color, shift), _mm256_set1_epi32(0xFF));
+    const __m256 scaled = _mm256_mul_ps(_mm256_cvtepi32_ps(channel), factor);
+    return _mm256_slli_epi32(_mm256_cvttps_epi32(_mm256_add_ps(scaled, _mm256_set1_ps(0.5f))), shift);
+}
+
+// Point samples one level, the same texels as MipChain::sample_nearest
+template <typename Level>
+AKG_TARGET_AVX2
+void fetch_texels_avx2(const Raster::FragmentBatch& batch, const Level& diffuse, uint32_t* texels) {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const __m256 u = _mm256_min_ps(_mm256_max_ps(_mm256_load_ps(batch.u), zero), one);
+    const __m256 v = _mm256_sub_ps(one, _mm256_min_ps(_mm256_max_ps(_mm256_load_ps(batch.v), zero), one));
+    const __m256i x = _mm256_min_epi32(_mm256_max_epi32(
+        _mm256_cvttps_epi32(_mm256_mul_ps(u, _mm256_set1_ps(static_cast<float>(diffuse.get_width())))),
+        _mm256_setzero_si256()), _mm256_set1_epi32(diffuse.get_width() - 1));
+    const __m256i y = _mm256_min_epi32(_mm256_max_epi32(
+        _mm256_cvttps_epi32(_mm256_mul_ps(v, _mm256_set1_ps(static_cast<float>(diffuse.get_height())))),
+        _mm256_setzero_si256()), _mm256_set1_epi32(diffuse.get_height() - 1));
+
+    alignas(32) int32_t texel_x[Raster::BATCH_SIZE];
+    alignas(32) int32_t texel_y[Raster::BATCH_SIZE];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(texel_x), x);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(texel_y), y);
+    gather_texels(diffuse, texel_x, texel_y, texels, Raster::BATCH_SIZE);
+}
+
+AKG_TARGET_AVX2
+void shade_batch_avx2(const Raster::FragmentBatch& batch, uint32_t mask, const uint32_t* texels,
+                      const glm::vec3& sun, const SpecularInputs* specular, Color::RGBA* colors)
+{
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+
+    const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    const __m256i active = _mm256_cmpeq_epi32(
+        _mm256_and_si256(_mm256_set1_epi32(static_cast<int>(mask)), lane_bits), lane_bits);
+    const __m256 active_ps = _mm256_castsi256_ps(active);
+
+    __m256 nx = _mm256_and_ps(_mm256_load_ps(batch.normal_x), active_ps);
+    __m256 ny = _mm256_and_ps(_mm256_load_ps(batch.normal_y), active_ps);
+    __m256 nz = _mm256_blendv_ps(one, _mm256_load_ps(batch.normal_z), active_ps);
+    nx = _mm256_add_ps(nx, nx);
+    ny = _mm256_add_ps(ny, ny);
+    nz = _mm256_add_ps(nz, nz);
+    normalize_avx2(nx, ny, nz);
+
+    const __m256 wx = _mm256_load_ps(batch.world_x);
+    const __m256 wy = _mm256_load_ps(batch.world_y);
+    const __m256 wz = _mm256_load_ps(batch.world_z);
+    __m256 lx = _mm256_sub_ps(_mm256_set1_ps(sun.x), wx);
+    __m256 ly = _mm256_sub_ps(_mm256_set1_ps(sun.y), wy);
+    __m256 lz = _mm256_sub_ps(_mm256_set1_ps(sun.z), wz);
+    normalize_avx2(lx, ly, lz);
+
+    const __m256 nl = _mm256_add_ps(
+        _mm256_add_ps(_mm256_mul_ps(nx, lx), _mm256_mul_ps(ny, ly)), _mm256_mul_ps(nz, lz));
+    const __m256 lit = _mm256_cmp_ps(nl, zero, _CMP_GT_OQ);
+    const __m256 diffuse_coef = _mm256_min_ps(_mm256_max_ps(
+        _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(kd), nl), _mm256_set1_ps(2.0f)), zero), one);
+    const __m256 factor = _mm256_blendv_ps(_mm256_set1_ps(ka), diffuse_coef, lit);
+
+    const __m256i color = _mm256_load_si256(reinterpret_cast<const __m256i*>(texels));
+    __m256i result = _mm256_or_si256(
+        _mm256_or_si256(_mm256_set1_epi32(static_cast<int>(0xFF000000)), scale_channel_avx2(color, factor, 16)),
+        _mm256_or_si256(scale_channel_avx2(color, factor, 8), scale_channel_avx2(color, factor, 0)));
+
+    if (specular) {
+        __m256 vx = _mm256_sub_ps(_mm256_set1_ps(specular->eye.x), wx);
+        __m256 vy = _mm256_sub_ps(_mm256_set1_ps(specular->eye.y), wy);
+        __m256 vz = _mm256_sub_ps(_mm256_set1_ps(specular->eye.z), wz);
+        normalize_avx2(vx, vy, vz);
+        __m256 hx = _mm256_add_ps(lx, vx);
+        __m256 hy = _mm256_add_ps(ly, vy);
+        __m256 hz = _mm256_add_ps(lz, vz);
+        normalize_avx2(hx, hy, hz);
+
+        const __m256 nh = _mm256_max_ps(_mm256_add_ps(
+            _mm256_add_ps(_mm256_mul_ps(nx, hx), _mm256_mul_ps(ny, hy)), _mm256_mul_ps(nz, hz)), zero);
+        const __m256 specular_coef = _mm256_and_ps(lit, _mm256_min_ps(_mm256_max_ps(
+            _mm256_mul_ps(_mm256_set1_ps(ks), specular->power.evaluate_avx2(nh, specular->mode)), zero), one));
+
+        const __m256i specular_color = _mm256_load_si256(reinterpret_cast<const __m256i*>(specular->texels));
+        const __m256i highlight = _mm256_or_si256(scale_channel_avx2(specular_color, specular_coef, 16),
+            _mm256_or_si256(scale_channel_avx2(specular_color, specular_coef, 8), 
+                            scale_channel_avx2(specular_color, specular_coef, 0)));
+        result = _mm256_adds_epu8(result, highlight);
+    }
+    _mm256_maskstore_epi32(reinterpret_cast<int*>(colors), active, result);
+}
+
+constexpr int SSE_LANES = 4;
+
+AKG_TARGET_SSE41
+void normalize_sse41(__m128& x, __m128& y, __m128& z) {
+    const __m128 length_squared = _mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+    const __m128 inv_length = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(length_squared));
+    x = _mm_mul_ps(x, inv_length);
+    y = _mm_mul_ps(y, inv_length);
+    z = _mm_mul_ps(z, inv_length);
 }
 
+AKG_TARGET_SSE41
+__m128i scale_channel_sse41(__m128i color, __m128 factor, int shift) {
+    const __m128i channel = _mm_and_si128(_mm_srli_epi32(color, shift), _mm_set1_epi32(0xFF));
+    const __m128 scaled = _mm_mul_ps(_mm_cvtepi32_ps(channel), factor);
+    return _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(scaled, _mm_set1_ps(0.5f))), shift);
+}
+
+template <typename Level>
+AKG_TARGET_SSE41
+void fetch_texels_sse41(const Raster::FragmentBatch& batch, const Level& diffuse, uint32_t* texels) {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+
+    for (int offset = 0; offset < Raster::BATCH_SIZE; offset += SSE_LANES) {
+        const __m128 u = _mm_min_ps(_mm_max_ps(_mm_load_ps(batch.u + offset), zero), one);
+        const __m128 v = _mm_sub_ps(one, _mm_min_ps(_mm_max_ps(_mm_load_ps(batch.v + offset), zero), one));
+        const __m128i x = _mm_min_epi32(_mm_max_epi32(
+            _mm_cvttps_epi32(_mm_mul_ps(u, _mm_set1_ps(static_cast<float>(diffuse.get_width())))),
+            _mm_setzero_si128()), _mm_set1_epi32(diffuse.get_width() - 1));
+        const __m128i y = _mm_min_epi32(_mm_max_epi32(
+            _mm_cvttps_epi32(_mm_mul_ps(v, _mm_set1_ps(static_cast<float>(diffuse.get_height())))),
+            _mm_setzero_si128()), _mm_set1_epi32(diffuse.get_height() - 1));
+
+        alignas(16) int32_t texel_x[SSE_LANES];
+        alignas(16) int32_t texel_y[SSE_LANES];
+        _mm_store_si128(reinterpret_cast<__m128i*>(texel_x), x);
+        _mm_store_si128(reinterpret_cast<__m128i*>(texel_y), y);
+        gather_texels(diffuse, texel_x, texel_y, texels + offset, SSE_LANES);
+    }
+}
+
+AKG_TARGET_SSE41
+void shade_batch_sse41(const Raster::FragmentBatch& batch, uint32_t mask, const uint32_t* texels,
+                       const glm::vec3& sun, const SpecularInputs* specular, Color::RGBA* colors)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+
+    for (int offset = 0; offset < Raster::BATCH_SIZE; offset += SSE_LANES) {
+        const __m128i active = _mm_cmpeq_epi32(
+            _mm_and_si128(_mm_set1_epi32(static_cast<int>(mask >> offset)), lane_bits), lane_bits);
+        if (_mm_testz_si128(active, active)) {
+            continue;
+        }
+        const __m128 active_ps = _mm_castsi128_ps(active);
+
+        __m128 nx = _mm_and_ps(_mm_load_ps(batch.normal_x + offset), active_ps);
+        __m128 ny = _mm_and_ps(_mm_load_ps(batch.normal_y + offset), active_ps);
+        __m128 nz = _mm_blendv_ps(one, _mm_load_ps(batch.normal_z + offset), active_ps);
+        nx = _mm_add_ps(nx, nx);
+        ny = _mm_add_ps(ny, ny);
+        nz = _mm_add_ps(nz, nz);
+        normalize_sse41(nx, ny, nz);
+
+        const __m128 wx = _mm_load_ps(batch.world_x + offset);
+        const __m128 wy = _mm_load_ps(batch.world_y + offset);
+        const __m128 wz = _mm_load_ps(batch.world_z + offset);
+        __m128 lx = _mm_sub_ps(_mm_set1_ps(sun.x), wx);
+        __m128 ly = _mm_sub_ps(_mm_set1_ps(sun.y), wy);
+        __m128 lz = _mm_sub_ps(_mm_set1_ps(sun.z), wz);
+        normalize_sse41(lx, ly, lz);
+
+        const __m128 nl = _mm_add_ps(
+            _mm_add_ps(_mm_mul_ps(nx, lx), _mm_mul_ps(ny, ly)), _mm_mul_ps(nz, lz));
+        const __m128 lit = _mm_cmpgt_ps(nl, zero);
+        const __m128 diffuse_coef = _mm_min_ps(_mm_max_ps(
+            _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(kd), nl), _mm_set1_ps(2.0f)), zero), one);
+        const __m128 factor = _mm_blendv_ps(_mm_set1_ps(ka), diffuse_coef, lit);
+
+        const __m128i color = _mm_load_si128(reinterpret_cast<const __m128i*>(texels + offset));
+        __m128i result = _mm_or_si128(
+            _mm_or_si128(_mm_set1_epi32(static_cast<int>(0xFF000000)), scale_channel_sse41(color, factor, 16)),
+            _mm_or_si128(scale_channel_sse41(color, factor, 8), scale_channel_sse41(color, factor, 0)));
+
+        if (specular) {
+            __m128 vx = _mm_sub_ps(_mm_set1_ps(specular->eye.x), wx);
+            __m128 vy = _mm_sub_ps(_mm_set1_ps(specular->eye.y), wy);
+            __m128 vz = _mm_sub_ps(_mm_set1_ps(specular->eye.z), wz);
+            normalize_sse41(vx, vy, vz);
+            __m128 hx = _mm_add_ps(lx, vx);
+            __m128 hy = _mm_add_ps(ly, vy);
+            __m128 hz = _mm_add_ps(lz, vz);
+            normalize_sse41(hx, hy, hz);
+
+            const __m128 nh = _mm_max_ps(_mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(nx, hx), _mm_mul_ps(ny, hy)), _mm_mul_ps(nz, hz)), zero);
+            const __m128 specular_coef = _mm_and_ps(lit, _mm_min_ps(_mm_max_ps(
+                _mm_mul_ps(_mm_set1_ps(ks), specular->power.evaluate_sse41(nh, specular->mode)), zero), one));
+
+            const __m128i specular_color = _mm_load_si128(reinterpret_cast<const __m128i*>(specular->texels + offset));
+            const __m128i highlight = _mm_or_si128(scale_channel_sse41(specular_color, specular_coef, 16),
+                _mm_or_si128(scale_channel_sse41(specular_color, specular_coef, 8), 
+                             scale_channel_sse41(specular_color, specular_coef, 0)));
+            result = _mm_adds_epu8(result, highlight);
+        }
+        __m128i* target = reinterpret_cast<__m128i*>(colors + offset);
+        _mm_storeu_si128(target, _mm_blendv_epi8(_mm_loadu_si128(target), result, active));
+    }
+}
+
+#endif
+
 } // namespace
 
-Raster::Raster() noexcept {
+Raster::Texture Raster::load_texture(const std::string& filename, Texture2D::Layout layout) {
+    const RawTexture raw = map_texture(filename);
+
+    Texture texture(TEXTURE_WIDTH, TEXTURE_HEIGHT, layout);
+    for (int y = 0; y < TEXTURE_HEIGHT; ++y) {
+        const uint8_t* row = raw.get_row(y);
+        for (int x = 0; x < TEXTURE_WIDTH; ++x) {
+            texture.set(x, y, RawTexture::pack(row + x * RawTexture::BYTES_PER_TEXEL));
+        }
+    }
+
+    return texture;
+}
+
+RawTexture Raster::map_texture(const std::string& filename) {
+    return RawTexture(filename, TEXTURE_WIDTH, TEXTURE_HEIGHT);
+}
+
+MipChain Raster::load_cached(const std::string& filename, bool compress, BlockTexture::Format format) {
+    const std::string cache = filename + (!compress ? ".rgba" : format == BlockTexture::Format::BC4 ? ".bc4" : ".bc1");
+
+    // Without the raw file the cache is used as is
+    std::error_code cache_error;
+    std::error_code source_error;
+    const auto cache_time = std::filesystem::last_write_time(cache, cache_error);
+    const auto source_time = std::filesystem::last_write_time(filename, source_error);
+    if (!cache_error && (source_error || cache_time >= source_time)) {
+        try {
+            MipChain chain = MipChain::load(cache);
+            const bool matches = chain.is_compressed() == compress && (compress 
+                ? has_texture_size(chain.get_compressed_level(0)) && chain.get_compressed_level(0).get_format() == format
+                : has_texture_size(chain.get_level(0)) && chain.get_level(0).get_layout() == TEXTURE_LAYOUT);
+            if (matches) {
+                return chain;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Texture cache error: " << e.what() << std::endl;
+        }
+    }
+
+    MipChain chain(load_texture(filename));
+    if (compress) {
+        chain.compress(format);
+    }
+    try {
+        chain.save(cache);
+        // The mapped chain replaces the built one, so texels never read take no memory
+        return MipChain::load(cache);
+    } catch (const std::exception& e) {
+        std::cerr << "Texture cache error: " << e.what() << std::endl;
+    }
+    return chain;
+}
+
+Raster::Raster(bool texture_compression) noexcept 
+    : m_specular(a, DEFAULT_SPECULAR_ERROR)
+    , m_use_avx2(Simd::has_avx2())
+    , m_use_sse41(Simd::has_sse41())
+    , m_texture_compression(texture_compression)
+    , m_loader(std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+{
     std::vector<std::string> diffuse = {
         "../model/Knight/Textures/hellknight_body.raw",
         "../model/Knight/Textures/hellknight_head.raw",
@@ -87,28 +369,65 @@ Raster::Raster() noexcept {
         "../model/Knight/Textures/hellknight_eyes_s.raw",
     };
 
+    for (int i = 0; i < TEXTURES_COUNT; ++i){
+        arr_diffuse.emplace_back(Texture(1, 1, TEXTURE_LAYOUT, DIFFUSE_PLACEHOLDER));
+        arr_specular.emplace_back(Texture(1, 1, TEXTURE_LAYOUT, SPECULAR_PLACEHOLDER));
+        m_materials.push_back(Material{i, i, i});
+    }
+
+    // The vectors are not resized any more, so the jobs may keep pointers to their elements
+    for (int i = 0; i < TEXTURES_COUNT; ++i){
+        start_loading(arr_diffuse[i], diffuse[i], BlockTexture::Format::BC1);
+        start_loading(arr_specular[i], specular[i], BlockTexture::Format::BC4);
+    }
+
+    // Mapping takes microseconds and the normal maps are not sampled while shading, 
+    // so they are mapped right away and take no memory until read
     try {
-        for (int i = 0; i < NUMBER_TEXTURES; ++i){
-            arr_diffuse.push_back(load_texture(diffuse[i]));
-            arr_normal.push_back(load_texture(normal[i]));
-            arr_specular.push_back(load_texture(specular[i]));
+        for (int i = 0; i < TEXTURES_COUNT; ++i){
+            arr_normal.push_back(map_texture(normal[i]));
         }
     } catch (const std::exception& e) {
         std::cerr << "Texture loading error: " << e.what() << std::endl;
-        for (int i = 0; i < NUMBER_TEXTURES; ++i){
-            arr_diffuse.push_back(std::vector<std::vector<uint32_t>>(TEXTURE_HEIGHT, std::vector<uint32_t>(TEXTURE_WIDTH, 0)));
-            arr_normal.push_back(std::vector<std::vector<uint32_t>>(TEXTURE_HEIGHT, std::vector<uint32_t>(TEXTURE_WIDTH, 0)));
-            arr_specular.push_back(std::vector<std::vector<uint32_t>>(TEXTURE_HEIGHT, std::vector<uint32_t>(TEXTURE_WIDTH, 0)));
-        }
+        arr_normal.clear();
     }
 }
 
-void Raster::reset_texture(){
-    index = 0;
+void Raster::start_loading(MipChain& target, const std::string& filename, BlockTexture::Format format) {
+    // Jobs build their mip levels on their own thread, waiting for bands queued 
+    // behind other jobs in the same pool could block every worker
+    m_pending.push_back(PendingTexture{&target, m_loader.add_task([filename, format, compress = m_texture_compression] {
+        return std::make_shared<MipChain>(
+            load_cached(filename, compress, format));
+    })});
+}
+
+void Raster::update_textures() {
+    std::erase_if(m_pending, [](PendingTexture& pending) {
+        if (pending.result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+
+        try {
+            *pending.target = std::move(*std::any_cast<std::shared_ptr<MipChain>>(pending.result.get()));
+        } catch (const std::exception& e) {
+            std::cerr << "Texture loading error: " << e.what() << std::endl;
+        }
+        return true;
+    });
+}
+
+void Raster::wait_for_textures() {
+    std::ranges::for_each(m_pending, [](const PendingTexture& pending) { pending.result.wait(); });
+    update_textures();
+}
+
+int Raster::get_pending_textures() const {
+    return static_cast<int>(m_pending.size());
 }
 
-void Raster::next_texture() {
-    index = (index + 1) % NUMBER_TEXTURES;
+bool Raster::get_texture_compression() const {
+    return m_texture_compression;
 }
 
 void Raster::set_eye(const glm::vec3& eye) {
@@ -119,15 +438,15 @@ void Raster::set_sun(const glm::vec3& sun) {
     m_sun = sun;
 }
 
-Color::RGBA Raster::get_color(const PointData& point) {
+Color::RGBA Raster::get_color(const PointData& point, int material, float lod) const {
     const auto& [world, normal, texture] = point;
+    const Material& textures = m_materials[material];
     
-    Color::RGBA DColor = getPixel(arr_diffuse[index], texture.x, texture.y); 
+    Color::RGBA DColor = arr_diffuse[textures.diffuse].sample(texture.x, texture.y, lod, m_texture_filter); 
     glm::vec3 tex_normal = normal;
     
     glm::vec3 N = glm::normalize(normal + tex_normal);
     glm::vec3 L = glm::normalize(m_sun - world);
-    glm::vec3 V = glm::normalize(m_eye - world);
     
     Color::RGBA Ia = Color::multiply(DColor, ka);
     
@@ -138,11 +457,89 @@ Color::RGBA Raster::get_color(const PointData& point) {
     
     float diffuse_coef = kd * NL * 2;
     Color::RGBA Id = Color::multiply(DColor, diffuse_coef);
+
+    if (m_specular_mode == SpecularMode::Off) {
+        return Id;
+    }
     
+    glm::vec3 V = glm::normalize(m_eye - world);
     glm::vec3 H = glm::normalize(L + V);
-    uint32_t spec_value = getPixel(arr_specular[index], texture.x, texture.y);
-    float specular_coef = ks * std::pow(std::max(0.0f, glm::dot(N, H)), a);
+    uint32_t spec_value = arr_specular[textures.specular].sample(texture.x, texture.y, lod, m_texture_filter);
+    const float NH = std::max(0.0f, glm::dot(N, H));
+    float specular_coef = ks * m_specular.evaluate(NH, get_power_mode(m_specular_mode));
     Color::RGBA Is = Color::multiply(spec_value, specular_coef);
     
-    return Id;
-}
\ No newline at end of file
+    return Color::add(Id, Is);
+}
+
+void Raster::set_specular_mode(SpecularMode mode) {
+    m_specular_mode = mode;
+}
+
+Raster::SpecularMode Raster::get_specular_mode() const {
+    return m_specular_mode;
+}
+
+void Raster::set_specular_error(float max_error) {
+    m_specular = SpecularPower(a, max_error);
+}
+
+float Raster::get_specular_error() const {
+    return m_specular.get_max_error();
+}
+
+void Raster::set_texture_filter(MipChain::Filter filter) {
+    m_texture_filter = filter;
+}
+
+MipChain::Filter Raster::get_texture_filter() const {
+    return m_texture_filter;
+}
+
+int Raster::get_materials_count() const {
+    return static_cast<int>(m_materials.size());
+}
+
+void Raster::get_colors(const FragmentBatch& batch, uint32_t mask, int material, float lod, Color::RGBA* colors) const {
+#ifdef AKG_SIMD_X86
+    if (m_use_avx2 || m_use_sse41) {
+        const auto fetch_chain = [&](const MipChain& chain, uint32_t* texels) {
+            if (m_texture_filter != MipChain::Filter::Nearest) {
+                for (uint32_t lanes = mask; lanes != 0; lanes &= lanes - 1) {
+                    const int lane = std::countr_zero(lanes);
+                    texels[lane] = chain.sample(batch.u[lane], batch.v[lane], lod, m_texture_filter);
+                }
+                return;
+            }
+            const auto fetch = [&](const auto& level) {
+                m_use_avx2 ? fetch_texels_avx2(batch, level, texels) : fetch_texels_sse41(batch, level, texels);
+            };
+            const int level = chain.get_level_index(lod);
+            chain.is_compressed() ? fetch(chain.get_compressed_level(level)) : fetch(chain.get_level(level));
+        };
+
+        alignas(32) uint32_t texels[BATCH_SIZE]{};
+        fetch_chain(arr_diffuse[m_materials[material].diffuse], texels);
+
+        alignas(32) uint32_t specular_texels[BATCH_SIZE]{};
+        std::optional<SpecularInputs> specular;
+        if (m_specular_mode != SpecularMode::Off) {
+            fetch_chain(arr_specular[m_materials[material].specular], specular_texels);
+            specular.emplace(specular_texels, m_eye, m_specular, get_power_mode(m_specular_mode));
+        }
+
+        const SpecularInputs* inputs = specular ? &*specular : nullptr;
+        m_use_avx2 ? shade_batch_avx2(batch, mask, texels, m_sun, inputs, colors) 
+                   : shade_batch_sse41(batch, mask, texels, m_sun, inputs, colors);
+        return;
+    }
+#endif
+
+    for (uint32_t lanes = mask; lanes != 0; lanes &= lanes - 1) {
+        const int lane = std::countr_zero(lanes);
+        const Vertex world{batch.world_x[lane], batch.world_y[lane], batch.world_z[lane]};
+        const Vertex normal{batch.normal_x[lane], batch.normal_y[lane], batch.normal_z[lane]};
+        const TextureVertex texture{batch.u[lane], batch.v[lane]};
+        colors[lane] = get_color(PointData{world, normal, texture}, material, lod);
+    }
+}
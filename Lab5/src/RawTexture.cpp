@@ -0,0 +1,24 @@
+#include "RawTexture.hpp"
+#include <stdexcept>
+
+RawTexture::RawTexture(const std::string& filename, int width, int height)
+    : m_file(filename)
+    , m_width(width)
+    , m_height(height)
+{
+    if (m_file.size() < static_cast<size_t>(width) * height * BYTES_PER_TEXEL) {
+        throw std::runtime_error("Unexpected end of file in texture: " + filename);
+    }
+}
+
+const uint8_t* RawTexture::data() const {
+    return m_file.data();
+}
+
+int RawTexture::get_width() const {
+    return m_width;
+}
+
+int RawTexture::get_height() const {
+    return m_height;
+}
@@ -1,35 +1,319 @@
 #include "Renderer.hpp"
+#include "Simd.hpp"
 #include <algorithm>
 #include <iostream>
+#include <thread>
+#include <bit>
+#include <chrono>
 
 namespace {
 
-constexpr int WIDTH{1600};
-constexpr int HEIGHT{900};
+// Buffers are allocated once for the largest resolution, 
+// set_resolution only changes the part of them in use
+constexpr int MAX_WIDTH{1600};
+constexpr int MAX_HEIGHT{900};
 constexpr float FOV{PI / 4.0f};
 constexpr float ZNEAR{0.4f}; 
 constexpr float ZFAR{1000.f}; 
-constexpr float ASPECT = static_cast<float>(WIDTH) / HEIGHT; 
+constexpr float DEPTH_CLEAR{1.0f};
+constexpr Color::RGBA COLOR_CLEAR{0};
+constexpr int TILE_SIZE{64};
+
+using Clock = std::chrono::steady_clock;
+
+float get_elapsed_ms(Clock::time_point start) {
+    return std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+int get_threads_count() {
+    return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
 
 template<typename T>
 T lerp(const T& a, const T& b, float t){
     return (1 - t) * a + t * b;
 }
 
-bool check_vertex(const ScreenVertex& vertex) {
-    return vertex.z >= -1 && vertex.z <= 1;
+// Distance from the screen edges beyond which triangles are clipped instead of 
+// being left to the rasterizer, keeps screen coordinates of clipped triangles bounded
+constexpr float GUARD_BAND{1024.f};
+constexpr int CLIP_PLANES_COUNT{6};
+
+enum ClipPlane : uint8_t {
+    CLIP_NEAR   = 1 << 0,
+    CLIP_FAR    = 1 << 1,
+    CLIP_LEFT   = 1 << 2,
+    CLIP_RIGHT  = 1 << 3,
+    CLIP_TOP    = 1 << 4,
+    CLIP_BOTTOM = 1 << 5
+};
+
+// Clip-space vertices already went through the viewport matrix, so the depth range is 
+// -w <= z <= w and the guard band is -GUARD_BAND * w <= x <= (MAX_WIDTH + GUARD_BAND) * w.
+// The band is measured from the largest resolution, so it does not depend on the current one
+float get_clip_distance(const ScreenVertex& v, int plane) {
+    switch (plane) {
+        case 0: return v.z + v.w;
+        case 1: return v.w - v.z;
+        case 2: return v.x + GUARD_BAND * v.w;
+        case 3: return (MAX_WIDTH + GUARD_BAND) * v.w - v.x;
+        case 4: return v.y + GUARD_BAND * v.w;
+        default: return (MAX_HEIGHT + GUARD_BAND) * v.w - v.y;
+    }
 }
 
+uint8_t get_clip_code(const ScreenVertex& v) {
+    uint8_t code = 0;
+    for (int plane = 0; plane < CLIP_PLANES_COUNT; ++plane) {
+        if (get_clip_distance(v, plane) < 0) {
+            code |= 1 << plane;
+        }
+    }
+    return code;
+}
+
+ScreenVertex project(const ScreenVertex& clip) {
+    ScreenVertex screen = clip;
+    if (screen.w != 0) {
+        screen.x /= screen.w;
+        screen.y /= screen.w;
+        screen.z /= screen.w;
+    }
+    return screen;
+}
+
+struct Bounds {
+    int min_x, min_y;
+    int max_x, max_y;
+
+    bool empty() const {
+        return min_x >= max_x || min_y >= max_y;
+    }
+};
+
+// Screen area a triangle may touch, clamped to the screen
+Bounds get_bounds(const ScreenVertex& s1, const ScreenVertex& s2, const ScreenVertex& s3, 
+                  int width, int height) 
+{
+    const int x1 = static_cast<int>(std::round(s1.x));
+    const int y1 = static_cast<int>(std::round(s1.y));
+    const int x2 = static_cast<int>(std::round(s2.x));
+    const int y2 = static_cast<int>(std::round(s2.y));
+    const int x3 = static_cast<int>(std::round(s3.x));
+    const int y3 = static_cast<int>(std::round(s3.y));
+
+    // draw_triangle truncates lerped span ends, which may land one pixel 
+    // outside the rounded bounding box, so the box is widened by a pixel
+    return Bounds{
+        std::max(std::min({x1, x2, x3}) - 1, 0),
+        std::max(std::min({y1, y2, y3}), 0),
+        std::min(std::max({x1, x2, x3}) + 1, width),
+        std::min(std::max({y1, y2, y3}), height)
+    };
+}
+
+// The viewport flips y, so counter-clockwise front faces have a negative area on screen
+float get_signed_area(const ScreenVertex& s1, const ScreenVertex& s2, const ScreenVertex& s3) {
+    return (s2.x - s1.x) * (s3.y - s1.y) - (s3.x - s1.x) * (s2.y - s1.y);
+}
+
+// One level of detail for the whole triangle, half of log2 of the ratio between its 
+// areas in texels and in pixels. Under perspective it is the average over the triangle
+float get_texture_lod(const TextureVertex& t1, const TextureVertex& t2, const TextureVertex& t3, 
+                      float screen_area) 
+{
+    const glm::vec2 e1 = t2 - t1;
+    const glm::vec2 e2 = t3 - t1;
+    const float texture_area = std::abs(e1.x * e2.y - e2.x * e1.y) * 
+                               Raster::TEXTURE_WIDTH * Raster::TEXTURE_HEIGHT;
+    screen_area = std::abs(screen_area);
+    if (texture_area <= 0 || screen_area <= 0) {
+        return 0.0f;
+    }
+    return 0.5f * std::log2(texture_area / screen_area);
+}
+
+constexpr int BLOCK_SIZE{8};
+
+// Blocks are cleared lazily: the first depth test in a block during a frame clears it,
+// blocks nobody touched are filled with the clear color only when the frame is resolved
+enum BlockFlags : uint8_t {
+    BLOCK_CLEARED    = 1 << 0,  // depth and color were cleared this frame
+    BLOCK_BACKGROUND = 1 << 1   // color holds nothing but the clear color
+};
+
+constexpr int SUBPIXEL_BITS{4};
+constexpr int SUBPIXEL_STEP{1 << SUBPIXEL_BITS};
+
+// Edge values are clamped to this range before the int32 span tests, their sign 
+// cannot change within a block since a block spans far less than the margin
+constexpr int64_t EDGE_CLAMP{1 << 30};
+
+// Per-triangle setup of the half-space kernel. Vertices are snapped to 1/16 pixel,
+// edge functions are exact integers e(x, y) = a * x + b * y + c evaluated at the
+// center of pixel (x, y) and are non-negative inside the triangle. Depth, 1/w and 
+// the barycentrics of p1 and p2 divided by w are float planes relative to the origin
+struct TriangleSetup {
+    int64_t a[3], b[3], c[3];
+    int origin_x, origin_y;
+    float z[3];
+    float q[3];
+    float p1[3];
+    float p2[3];
+};
+
+// Steps of the edge functions and of depth across the 8 lanes of a span
+struct SpanSetup {
+    alignas(32) int32_t edge[3][BLOCK_SIZE];
+    alignas(32) float z[BLOCK_SIZE];
+};
+
+bool is_top_left(int64_t a, int64_t b) {
+    return a > 0 || (a == 0 && b > 0);
+}
+
+float get_plane(const float* plane, int x, int y) {
+    return plane[2] + plane[0] * x + plane[1] * y;
+}
+
+int32_t clamp_edge(int64_t edge) {
+    return static_cast<int32_t>(std::clamp(edge, -EDGE_CLAMP, EDGE_CLAMP));
+}
+
+// Returns the mask of span pixels that are inside the triangle and pass the depth test,
+// edge tests are skipped for spans of blocks that are known to be fully covered
+uint32_t span_mask_scalar(const SpanSetup& s, const int32_t* edge, float z, const float* z_buffer,
+                          bool covered, int lanes, float* z_out) 
+{
+    uint32_t mask = 0;
+    for (int lane = 0; lane < lanes; ++lane) {
+        const float depth = z + s.z[lane];
+        z_out[lane] = depth;
+
+        const bool inside = covered || (
+            edge[0] + s.edge[0][lane] >= 0 &&
+            edge[1] + s.edge[1][lane] >= 0 &&
+            edge[2] + s.edge[2][lane] >= 0
+        );
+        if (inside && depth < z_buffer[lane]) {
+            mask |= 1u << lane;
+        }
+    }
+    return mask;
+}
+
+#ifdef AKG_SIMD_X86
+
+AKG_TARGET_AVX2
+uint32_t span_mask_avx2(const SpanSetup& s, const int32_t* edge, float z, const float* z_buffer,
+                        bool covered, float* z_out) 
+{
+    const __m256 depth = _mm256_add_ps(_mm256_set1_ps(z), _mm256_load_ps(s.z));
+    _mm256_storeu_ps(z_out, depth);
+
+    __m256i inside = _mm256_castps_si256(_mm256_cmp_ps(depth, _mm256_loadu_ps(z_buffer), _CMP_LT_OQ));
+    if (!covered) {
+        const __m256i negative = _mm256_set1_epi32(-1);
+        for (int i = 0; i < 3; ++i) {
+            const __m256i steps = _mm256_load_si256(reinterpret_cast<const __m256i*>(s.edge[i]));
+            const __m256i values = _mm256_add_epi32(_mm256_set1_epi32(edge[i]), steps);
+            inside = _mm256_and_si256(inside, _mm256_cmpgt_epi32(values, negative));
+        }
+    }
+
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(inside)));
+}
+
+#endif
+
+}
+
+Renderer::Renderer(bool texture_compression) noexcept
+    : m_raster(texture_compression)
+    , m_pool(get_threads_count())
+    , m_use_avx2(Simd::has_avx2())
+{
+    // Vectors keep their capacity when shrinking, so lower resolutions never reallocate
+    set_resolution(MAX_WIDTH, MAX_HEIGHT);
 }
 
-Renderer::Renderer() noexcept
-    : m_data(WIDTH * HEIGHT)
-    , m_z_buffer(WIDTH * HEIGHT)
-{}
+void Renderer::set_resolution(int width, int height) {
+    width = std::clamp(width, 1, MAX_WIDTH);
+    height = std::clamp(height, 1, MAX_HEIGHT);
+    if (width == m_width && height == m_height) return;
+
+    m_width = width;
+    m_height = height;
+    m_tiles_x = (width + TILE_SIZE - 1) / TILE_SIZE;
+    m_tiles_y = (height + TILE_SIZE - 1) / TILE_SIZE;
+    m_blocks_x = (width + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    m_blocks_y = (height + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+    // Rows are packed with the new width, so the old contents are meaningless,
+    // the color is reset to the clear color and every block is marked as background
+    m_data.assign(width * height, COLOR_CLEAR);
+    m_z_buffer.resize(width * height);
+    m_visibility.resize(width * height);
+    m_hiz.resize(m_blocks_x * m_blocks_y);
+    m_block_flags.assign(m_blocks_x * m_blocks_y, BLOCK_BACKGROUND);
+    m_bins.resize(m_tiles_x * m_tiles_y);
+    m_tile_stats.resize(m_tiles_x * m_tiles_y);
+}
+
+int Renderer::get_width() const {
+    return m_width;
+}
+
+int Renderer::get_height() const {
+    return m_height;
+}
+
+int Renderer::get_block_index(int x, int y) const {
+    return (y / BLOCK_SIZE) * m_blocks_x + x / BLOCK_SIZE;
+}
 
 void Renderer::clear_bitmap(){
-    std::ranges::fill(m_data, 0);
-    std::ranges::fill(m_z_buffer, 1.0);
+    std::ranges::for_each(m_block_flags, [](uint8_t& flags) { flags &= ~BLOCK_CLEARED; });
+    std::ranges::fill(m_hiz, DEPTH_CLEAR);
+}
+
+void Renderer::clear_block(int block, TileStats& stats) {
+    const int x0 = (block % m_blocks_x) * BLOCK_SIZE;
+    const int y0 = (block / m_blocks_x) * BLOCK_SIZE;
+    const int x1 = std::min(x0 + BLOCK_SIZE, m_width);
+    const int y1 = std::min(y0 + BLOCK_SIZE, m_height);
+    const bool background = m_block_flags[block] & BLOCK_BACKGROUND;
+
+    for (int y = y0; y < y1; ++y) {
+        const int index = y * m_width;
+        std::fill(m_z_buffer.begin() + index + x0, m_z_buffer.begin() + index + x1, DEPTH_CLEAR);
+        if (!background) {
+            std::fill(m_data.begin() + index + x0, m_data.begin() + index + x1, COLOR_CLEAR);
+        }
+    }
+
+    // The block is about to be drawn into, so its color stops being pure background
+    m_block_flags[block] = BLOCK_CLEARED;
+    stats.cleared_blocks++;
+}
+
+void Renderer::resolve_blocks() {
+    for (int block = 0; block < m_blocks_x * m_blocks_y; ++block) {
+        if (m_block_flags[block] != 0) continue;
+
+        const int x0 = (block % m_blocks_x) * BLOCK_SIZE;
+        const int y0 = (block / m_blocks_x) * BLOCK_SIZE;
+        const int x1 = std::min(x0 + BLOCK_SIZE, m_width);
+        const int y1 = std::min(y0 + BLOCK_SIZE, m_height);
+
+        for (int y = y0; y < y1; ++y) {
+            const int index = y * m_width;
+            std::fill(m_data.begin() + index + x0, m_data.begin() + index + x1, COLOR_CLEAR);
+        }
+
+        m_block_flags[block] = BLOCK_BACKGROUND;
+        m_stats.resolved_blocks++;
+    }
 }
 
 const uint8_t* Renderer::data() const {
@@ -40,8 +324,271 @@ void Renderer::set_camera(std::shared_ptr<Camera> camera){
     m_camera = camera;
 }
 
-void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const PointData& p3) {
-    const PointData* points[3] = {&p1, &p2, &p3};
+void Renderer::set_raster_mode(RasterMode mode) {
+    m_raster_mode = mode;
+}
+
+Renderer::RasterMode Renderer::get_raster_mode() const {
+    return m_raster_mode;
+}
+
+void Renderer::set_shading_mode(ShadingMode mode) {
+    m_shading_mode = mode;
+}
+
+Renderer::ShadingMode Renderer::get_shading_mode() const {
+    return m_shading_mode;
+}
+
+void Renderer::set_backface_culling(bool enabled) {
+    m_backface_culling = enabled;
+}
+
+bool Renderer::get_backface_culling() const {
+    return m_backface_culling;
+}
+
+void Renderer::set_hierarchical_z(bool enabled) {
+    m_hierarchical_z = enabled;
+}
+
+bool Renderer::get_hierarchical_z() const {
+    return m_hierarchical_z;
+}
+
+void Renderer::set_specular_mode(Raster::SpecularMode mode) {
+    m_raster.set_specular_mode(mode);
+}
+
+Raster::SpecularMode Renderer::get_specular_mode() const {
+    return m_raster.get_specular_mode();
+}
+
+void Renderer::set_specular_error(float max_error) {
+    m_raster.set_specular_error(max_error);
+}
+
+float Renderer::get_specular_error() const {
+    return m_raster.get_specular_error();
+}
+
+void Renderer::set_texture_filter(MipChain::Filter filter) {
+    m_raster.set_texture_filter(filter);
+}
+
+MipChain::Filter Renderer::get_texture_filter() const {
+    return m_raster.get_texture_filter();
+}
+
+void Renderer::wait_for_textures() {
+    m_raster.wait_for_textures();
+}
+
+bool Renderer::get_texture_compression() const {
+    return m_raster.get_texture_compression();
+}
+
+const Renderer::Stats& Renderer::get_stats() const {
+    return m_stats;
+}
+
+int Renderer::clip_polygon(ClippedPolygon& polygon, int count, uint8_t planes) {
+    for (int plane = 0; plane < CLIP_PLANES_COUNT; ++plane) {
+        if ((planes & (1 << plane)) == 0) continue;
+
+        ClippedPolygon result;
+        int result_count = 0;
+
+        for (int i = 0; i < count; ++i) {
+            const auto& current = polygon[i];
+            const auto& next = polygon[(i + 1) % count];
+            const float current_distance = get_clip_distance(current.screen, plane);
+            const float next_distance = get_clip_distance(next.screen, plane);
+
+            if (current_distance >= 0) {
+                result[result_count++] = current;
+            }
+            if ((current_distance >= 0) != (next_distance >= 0)) {
+                // Attributes are linear in clip space, before the perspective divide
+                const float t = current_distance / (current_distance - next_distance);
+                result[result_count++] = ClippedVertex{
+                    lerp(current.world, next.world, t),
+                    lerp(current.screen, next.screen, t),
+                    lerp(current.normal, next.normal, t),
+                    lerp(current.texture, next.texture, t)
+                };
+            }
+        }
+
+        polygon = result;
+        count = result_count;
+        if (count < 3) return 0;
+    }
+    return count;
+}
+
+void Renderer::clip_triangle(const ClippedPolygon& triangle, int material, uint8_t planes) {
+    ClippedPolygon polygon = triangle;
+    const int count = clip_polygon(polygon, 3, planes);
+    if (count == 0) {
+        m_stats.culled_frustum++;
+        return;
+    }
+    m_stats.clipped++;
+
+    const size_t first = m_clipped_vertices.size();
+    for (int i = 0; i < count; ++i) {
+        auto& vertex = m_clipped_vertices.emplace_back(polygon[i]);
+        vertex.screen = project(vertex.screen);
+    }
+
+    auto get_point = [&](int i) {
+        const auto& vertex = m_clipped_vertices[first + i];
+        return PointData{vertex.world, vertex.screen, vertex.normal, vertex.texture};
+    };
+
+    for (int i = 1; i + 1 < count; ++i) {
+        submit_triangle(Triangle{get_point(0), get_point(i), get_point(i + 1), material});
+    }
+}
+
+void Renderer::submit_triangle(const Triangle& triangle) {
+    if (!cull_triangle(triangle.p1.screen, triangle.p2.screen, triangle.p3.screen)) {
+        bin_triangle(triangle);
+    }
+}
+
+bool Renderer::cull_triangle(const ScreenVertex& s1, const ScreenVertex& s2, const ScreenVertex& s3) {
+    const float area = get_signed_area(s1, s2, s3);
+    if (area == 0) {
+        m_stats.culled_degenerate++;
+        return true;
+    }
+    if (m_backface_culling && area > 0) {
+        m_stats.culled_backface++;
+        return true;
+    }
+
+    if (get_bounds(s1, s2, s3, m_width, m_height).empty()) {
+        m_stats.culled_offscreen++;
+        return true;
+    }
+
+    m_stats.submitted++;
+    return false;
+}
+
+void Renderer::bin_triangle(const Triangle& triangle) {
+    const auto [min_x, min_y, max_x, max_y] = get_bounds(
+        triangle.p1.screen, triangle.p2.screen, triangle.p3.screen, m_width, m_height);
+
+    const auto id = static_cast<uint32_t>(m_triangles.size());
+    m_triangles.push_back(triangle);
+    m_triangles.back().lod = get_texture_lod(triangle.p1.texture, triangle.p2.texture, triangle.p3.texture, 
+        get_signed_area(triangle.p1.screen, triangle.p2.screen, triangle.p3.screen));
+
+    for (int ty = min_y / TILE_SIZE; ty <= (max_y - 1) / TILE_SIZE; ++ty) {
+        for (int tx = min_x / TILE_SIZE; tx <= (max_x - 1) / TILE_SIZE; ++tx) {
+            m_bins[ty * m_tiles_x + tx].push_back(id);
+        }
+    }
+}
+
+void Renderer::draw_tile(int tile_index) {
+    const int tx = tile_index % m_tiles_x;
+    const int ty = tile_index / m_tiles_x;
+    const Tile tile{
+        tx * TILE_SIZE,
+        ty * TILE_SIZE,
+        std::min((tx + 1) * TILE_SIZE, m_width),
+        std::min((ty + 1) * TILE_SIZE, m_height),
+        tile_index
+    };
+
+    auto& stats = m_tile_stats[tile_index];
+    const auto raster_start = Clock::now();
+
+    if (m_raster_mode == RasterMode::HalfSpace) {
+        std::ranges::for_each(m_bins[tile_index], [&](uint32_t id) {
+            draw_triangle_half_space(id, tile);
+        });
+    } else {
+        std::ranges::for_each(m_bins[tile_index], [&](uint32_t id) {
+            draw_triangle(id, tile);
+        });
+    }
+    stats.raster_time = get_elapsed_ms(raster_start);
+
+    if (m_shading_mode == ShadingMode::Deferred) {
+        const auto shade_start = Clock::now();
+        shade_tile(tile);
+        stats.shade_time = get_elapsed_ms(shade_start);
+    }
+}
+
+void Renderer::shade_tile(const Tile& tile) {
+    for (int y = tile.y0; y < tile.y1; ++y) {
+        for (int x = tile.x0; x < tile.x1; ++x) {
+            const int index = y * m_width + x;
+            // Only pixels that passed a depth test this frame hold a valid sample,
+            // depth of blocks that were not cleared this frame is stale
+            if ((m_block_flags[get_block_index(x, y)] & BLOCK_CLEARED) && 
+                m_z_buffer[index] < DEPTH_CLEAR) 
+            {
+                const auto& [id, b1, b2] = m_visibility[index];
+                m_data[index] = shade_fragment(m_triangles[id], b1, b2, 1.0f - b1 - b2);
+            }
+        }
+    }
+}
+
+// Keeps the maximum depth of the 8x8 block up to date after the block was written
+void Renderer::update_hiz(int x0, int y0, int x1, int y1) {
+    float max_depth = 0;
+    for (int y = y0; y < y1; ++y) {
+        const auto row = m_z_buffer.begin() + y * m_width;
+        max_depth = std::max(max_depth, *std::max_element(row + x0, row + x1));
+    }
+    m_hiz[get_block_index(x0, y0)] = max_depth;
+}
+
+Color::RGBA Renderer::shade_fragment(const Triangle& triangle, float b1, float b2, float b3) const {
+    const auto& [w1, s1, n1, t1] = triangle.p1;
+    const auto& [w2, s2, n2, t2] = triangle.p2;
+    const auto& [w3, s3, n3, t3] = triangle.p3;
+
+    const glm::vec2 tex_coord = t1 * b1 + t2 * b2 + t3 * b3;
+    const glm::vec3 normal = glm::normalize(n1 * b1 + n2 * b2 + n3 * b3);
+    const glm::vec3 world = w1 * b1 + w2 * b2 + w3 * b3;
+
+    Raster::PointData point{world, normal, tex_coord};
+    return m_raster.get_color(point, triangle.material, triangle.lod);
+}
+
+void Renderer::set_fragment(Raster::FragmentBatch& batch, int lane, const Triangle& triangle, 
+                            float b1, float b2, float b3) const 
+{
+    const auto& [w1, s1, n1, t1] = triangle.p1;
+    const auto& [w2, s2, n2, t2] = triangle.p2;
+    const auto& [w3, s3, n3, t3] = triangle.p3;
+
+    const glm::vec3 world = w1 * b1 + w2 * b2 + w3 * b3;
+    const glm::vec3 normal = glm::normalize(n1 * b1 + n2 * b2 + n3 * b3);
+    const glm::vec2 tex_coord = t1 * b1 + t2 * b2 + t3 * b3;
+
+    batch.world_x[lane] = world.x;
+    batch.world_y[lane] = world.y;
+    batch.world_z[lane] = world.z;
+    batch.normal_x[lane] = normal.x;
+    batch.normal_y[lane] = normal.y;
+    batch.normal_z[lane] = normal.z;
+    batch.u[lane] = tex_coord.x;
+    batch.v[lane] = tex_coord.y;
+}
+
+void Renderer::draw_triangle(uint32_t id, const Tile& tile) {
+    const Triangle& triangle = m_triangles[id];
+    const PointData* points[3] = {&triangle.p1, &triangle.p2, &triangle.p3};
     
     std::sort(points, points + 3, [](const PointData* a, const PointData* b) {
         return a->screen.y < b->screen.y;
@@ -77,11 +624,23 @@ void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const Poi
     const glm::vec3 w2_persp = w2 * inv_w2;
     const glm::vec3 w3_persp = w3 * inv_w3;
 
+    // Barycentrics of the unsorted p1 and p2, needed by the visibility buffer
+    auto get_barycentric = [&](const PointData* point) {
+        return point == &triangle.p1 ? glm::vec2{1, 0}
+            : point == &triangle.p2 ? glm::vec2{0, 1}
+            : glm::vec2{0, 0};
+    };
+    const glm::vec2 b1_persp = get_barycentric(points[0]) * inv_w1;
+    const glm::vec2 b2_persp = get_barycentric(points[1]) * inv_w2;
+    const glm::vec2 b3_persp = get_barycentric(points[2]) * inv_w3;
+
+    const bool deferred = m_shading_mode == ShadingMode::Deferred;
+
     const int total_height = y3 - y1;
     if (total_height == 0) return;
 
-    int min_i = std::max(-y1, 0);
-    int max_i = std::min(y3, HEIGHT) - y1;
+    int min_i = std::max(tile.y0 - y1, 0);
+    int max_i = std::min(y3, tile.y1) - y1;
     
     for (int i = min_i; i < max_i; ++i) {
         bool second_half = i > (y2 - y1) || y2 == y1;
@@ -116,6 +675,11 @@ void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const Poi
             ? lerp(w2_persp, w3_persp, beta)
             : lerp(w1_persp, w2_persp, beta);
 
+        glm::vec2 Ab_persp = lerp(b1_persp, b3_persp, alpha);
+        glm::vec2 Bb_persp = second_half
+            ? lerp(b2_persp, b3_persp, beta)
+            : lerp(b1_persp, b2_persp, beta);
+
         int Ax = static_cast<int>(lerp(x1, x3, alpha));
         int Ay = y1 + i;
         int Bx = static_cast<int>(second_half 
@@ -130,18 +694,31 @@ void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const Poi
             std::swap(At_persp, Bt_persp);
             std::swap(An_persp, Bn_persp);
             std::swap(Aw_persp, Bw_persp);
+            std::swap(Ab_persp, Bb_persp);
         }
 
-        const int min_x = std::max(Ax, 0);
-        const int max_x = std::min(Bx, WIDTH);
-        const int index = Ay * WIDTH;
+        const int min_x = std::max(Ax, tile.x0);
+        const int max_x = std::min(Bx, tile.x1);
+        const int index = Ay * m_width;
 
         for (int x = min_x; x < max_x; ++x) {
             const float t = (x - Ax) / static_cast<float>(Bx - Ax);
             const float inv_w = lerp(inv_wA, inv_wB, t);
             const float z = lerp(zA, zB, t);
+
+            const int block = get_block_index(x, Ay);
+            if (!(m_block_flags[block] & BLOCK_CLEARED)) {
+                clear_block(block, m_tile_stats[tile.index]);
+            }
             
             if (z < m_z_buffer[index + x]) {
+                if (deferred) {
+                    const glm::vec2 barycentric = lerp(Ab_persp, Bb_persp, t) / inv_w;
+                    m_visibility[index + x] = {id, barycentric.x, barycentric.y};
+                    m_z_buffer[index + x] = z;
+                    continue;
+                }
+
                 const glm::vec2 tex_persp = lerp(At_persp, Bt_persp, t);
                 const glm::vec2 tex_coord = tex_persp / inv_w;
 
@@ -152,7 +729,7 @@ void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const Poi
                 const glm::vec3 world = world_persp / inv_w;
 
                 Raster::PointData point{world, normal, tex_coord};
-                Color::RGBA color = m_raster.get_color(point);
+                Color::RGBA color = m_raster.get_color(point, triangle.material, triangle.lod);
                 m_data[index + x] = color;
                 m_z_buffer[index + x] = z;
             }
@@ -160,35 +737,254 @@ void Renderer::draw_triangle(const PointData& p1, const PointData& p2, const Poi
     }
 }
 
+void Renderer::draw_triangle_half_space(uint32_t id, const Tile& tile) {
+    const Triangle& triangle = m_triangles[id];
+    const ScreenVertex* screen[3] = {&triangle.p1.screen, &triangle.p2.screen, &triangle.p3.screen};
+
+    int64_t X[3], Y[3];
+    for (int i = 0; i < 3; ++i) {
+        X[i] = std::lround(screen[i]->x * SUBPIXEL_STEP);
+        Y[i] = std::lround(screen[i]->y * SUBPIXEL_STEP);
+    }
+
+    const int64_t area = (X[1] - X[0]) * (Y[2] - Y[0]) - (X[2] - X[0]) * (Y[1] - Y[0]);
+    if (area == 0) return;
+    const int64_t orientation = area > 0 ? 1 : -1;
+
+    const int min_x = std::max(static_cast<int>(std::min({X[0], X[1], X[2]}) >> SUBPIXEL_BITS), tile.x0);
+    const int min_y = std::max(static_cast<int>(std::min({Y[0], Y[1], Y[2]}) >> SUBPIXEL_BITS), tile.y0);
+    const int max_x = std::min(static_cast<int>(std::max({X[0], X[1], X[2]}) >> SUBPIXEL_BITS) + 1, tile.x1);
+    const int max_y = std::min(static_cast<int>(std::max({Y[0], Y[1], Y[2]}) >> SUBPIXEL_BITS) + 1, tile.y1);
+    if (min_x >= max_x || min_y >= max_y) return;
+
+    TriangleSetup setup{};
+    setup.origin_x = min_x;
+    setup.origin_y = min_y;
+
+    // Edge i is opposite to vertex i, its function is the doubled area of the triangle 
+    // formed by the edge and the pixel center, so the three of them sum up to the area
+    const int64_t center = SUBPIXEL_STEP / 2;
+    const double inv_area = 1.0 / static_cast<double>(area * orientation);
+    double barycentric[3][3];
+
+    for (int i = 0; i < 3; ++i) {
+        const int j = (i + 1) % 3;
+        const int k = (i + 2) % 3;
+        const int64_t a = (Y[j] - Y[k]) * orientation;
+        const int64_t b = (X[k] - X[j]) * orientation;
+        const int64_t c = (a + b) * center + (X[j] * Y[k] - Y[j] * X[k]) * orientation;
+
+        setup.a[i] = a * SUBPIXEL_STEP;
+        setup.b[i] = b * SUBPIXEL_STEP;
+        setup.c[i] = c;
+
+        barycentric[i][0] = setup.a[i] * inv_area;
+        barycentric[i][1] = setup.b[i] * inv_area;
+        barycentric[i][2] = (setup.a[i] * min_x + setup.b[i] * min_y + c) * inv_area;
+
+        // Pixels on a shared edge belong to the top or left triangle only
+        if (!is_top_left(a, b)) {
+            setup.c[i] -= 1;
+        }
+    }
+
+    // Attribute planes are built in double relative to the origin, so per-pixel 
+    // interpolation is a couple of float adds without large cancelling terms
+    auto make_plane = [&](float* plane, float v1, float v2, float v3) {
+        for (int n = 0; n < 3; ++n) {
+            plane[n] = static_cast<float>(
+                barycentric[0][n] * v1 + barycentric[1][n] * v2 + barycentric[2][n] * v3);
+        }
+    };
+
+    const float inv_w1 = 1.0f / screen[0]->w;
+    const float inv_w2 = 1.0f / screen[1]->w;
+    const float inv_w3 = 1.0f / screen[2]->w;
+
+    make_plane(setup.z, screen[0]->z, screen[1]->z, screen[2]->z);
+    make_plane(setup.q, inv_w1, inv_w2, inv_w3);
+    make_plane(setup.p1, inv_w1, 0, 0);
+    make_plane(setup.p2, 0, inv_w2, 0);
+
+    SpanSetup span{};
+    for (int lane = 0; lane < BLOCK_SIZE; ++lane) {
+        for (int i = 0; i < 3; ++i) {
+            span.edge[i][lane] = static_cast<int32_t>(setup.a[i] * lane);
+        }
+        span.z[lane] = setup.z[0] * lane;
+    }
+
+    const int block_x0 = tile.x0 + (min_x - tile.x0) / BLOCK_SIZE * BLOCK_SIZE;
+    const int block_y0 = tile.y0 + (min_y - tile.y0) / BLOCK_SIZE * BLOCK_SIZE;
+
+    // Depth is linear in screen space, so no fragment is nearer than the nearest vertex
+    const float min_z = std::min({screen[0]->z, screen[1]->z, screen[2]->z});
+    auto& stats = m_tile_stats[tile.index];
+
+    if (m_hierarchical_z) {
+        float max_hiz = 0;
+        for (int by = block_y0; by < max_y; by += BLOCK_SIZE) {
+            for (int bx = block_x0; bx < max_x; bx += BLOCK_SIZE) {
+                max_hiz = std::max(max_hiz, m_hiz[get_block_index(bx, by)]);
+            }
+        }
+        if (min_z >= max_hiz) {
+            stats.hiz_rejected_triangles++;
+            return;
+        }
+    }
+
+    alignas(32) float depth[BLOCK_SIZE];
+    const bool deferred = m_shading_mode == ShadingMode::Deferred;
+
+    for (int by = block_y0; by < max_y; by += BLOCK_SIZE) {
+        const int row_begin = std::max(by, min_y);
+        const int row_end = std::min(by + BLOCK_SIZE, max_y);
+
+        for (int bx = block_x0; bx < max_x; bx += BLOCK_SIZE) {
+            const int lanes = std::min(BLOCK_SIZE, tile.x1 - bx);
+
+            if (m_hierarchical_z) {
+                stats.hiz_tested_blocks++;
+                if (min_z >= m_hiz[get_block_index(bx, by)]) {
+                    stats.hiz_rejected_blocks++;
+                    continue;
+                }
+            }
+
+            int64_t edge[3];
+            bool empty = false;
+            bool covered = true;
+
+            // Edge functions are linear, so the block corners bound them over the block
+            for (int i = 0; i < 3; ++i) {
+                edge[i] = setup.a[i] * bx + setup.b[i] * row_begin + setup.c[i];
+                const int64_t dx = setup.a[i] * (lanes - 1);
+                const int64_t dy = setup.b[i] * (row_end - 1 - row_begin);
+                const int64_t low = edge[i] + std::min<int64_t>(dx, 0) + std::min<int64_t>(dy, 0);
+                const int64_t high = edge[i] + std::max<int64_t>(dx, 0) + std::max<int64_t>(dy, 0);
+                empty |= high < 0;
+                covered &= low >= 0;
+            }
+            if (empty) continue;
+
+            const int block = get_block_index(bx, by);
+            if (!(m_block_flags[block] & BLOCK_CLEARED)) {
+                clear_block(block, stats);
+            }
+
+            const uint32_t lanes_mask = (1u << lanes) - 1;
+            const int local_x = bx - setup.origin_x;
+            bool written = false;
+
+            for (int y = row_begin; y < row_end; ++y) {
+                const int index = y * m_width + bx;
+                const int local_y = y - setup.origin_y;
+
+                const int64_t row = y - row_begin;
+                const int32_t row_edge[3] = {
+                    clamp_edge(edge[0] + setup.b[0] * row),
+                    clamp_edge(edge[1] + setup.b[1] * row),
+                    clamp_edge(edge[2] + setup.b[2] * row)
+                };
+                const float row_z = get_plane(setup.z, local_x, local_y);
+
+                uint32_t mask = 0;
+                if (m_use_avx2 && lanes == BLOCK_SIZE) {
+#ifdef AKG_SIMD_X86
+                    mask = span_mask_avx2(span, row_edge, row_z, &m_z_buffer[index], covered, depth);
+#endif
+                } else {
+                    mask = span_mask_scalar(span, row_edge, row_z, &m_z_buffer[index], covered, lanes, depth);
+                }
+                mask &= lanes_mask;
+
+                if (mask == 0) continue;
+                written = true;
+
+                const float row_q = get_plane(setup.q, local_x, local_y);
+                const float row_p1 = get_plane(setup.p1, local_x, local_y);
+                const float row_p2 = get_plane(setup.p2, local_x, local_y);
+
+                // Forward shading runs over the covered lanes of the span at once
+                Raster::FragmentBatch batch{};
+                const uint32_t span_mask = mask;
+
+                while (mask != 0) {
+                    const int lane = std::countr_zero(mask);
+                    mask &= mask - 1;
+
+                    // The only per-pixel division, the perspective correction
+                    const float w = 1.0f / (row_q + setup.q[0] * lane);
+                    const float b1 = (row_p1 + setup.p1[0] * lane) * w;
+                    const float b2 = (row_p2 + setup.p2[0] * lane) * w;
+
+                    if (deferred) {
+                        m_visibility[index + lane] = {id, b1, b2};
+                    } else {
+                        set_fragment(batch, lane, triangle, b1, b2, 1.0f - b1 - b2);
+                    }
+                    m_z_buffer[index + lane] = depth[lane];
+                }
+
+                if (!deferred) {
+                    Color::RGBA colors[Raster::BATCH_SIZE];
+                    m_raster.get_colors(batch, span_mask, triangle.material, triangle.lod, colors);
+                    for (uint32_t lanes_left = span_mask; lanes_left != 0; lanes_left &= lanes_left - 1) {
+                        const int lane = std::countr_zero(lanes_left);
+                        m_data[index + lane] = colors[lane];
+                    }
+                }
+            }
+
+            if (written && m_hierarchical_z) {
+                update_hiz(bx, by, bx + lanes, std::min(by + BLOCK_SIZE, tile.y1));
+            }
+        }
+    }
+}
+
 void Renderer::draw(const Vertices& vertices, const Faces& faces, 
                     const Vertices& normals, const TextureVertices& texture_vertices,
-                    const Mtls& mtls) 
+                    const MaterialIds& material_ids) 
 {
+    const auto draw_start = Clock::now();
+    m_raster.update_textures();
+
     const glm::vec3 eye = m_camera->get_eye();
     m_raster.set_eye(eye);
     m_raster.set_sun(eye);
 
     clear_bitmap();
-    auto screen_vertices = get_screen_vertices(vertices);
 
-    int mtl_index = 0;
-    int mtl_count = 0;
+    m_clip_vertices = get_clip_vertices(vertices);
+    m_screen_vertices.resize(m_clip_vertices.size());
+    m_clip_codes.resize(m_clip_vertices.size());
+    std::ranges::transform(m_clip_vertices, m_screen_vertices.begin(), project);
+    std::ranges::transform(m_clip_vertices, m_clip_codes.begin(), get_clip_code);
+    m_clipped_vertices.clear();
 
-    m_raster.reset_texture();
+    m_stats = Stats{};
+    m_stats.faces = static_cast<int>(faces.size());
+    m_stats.width = m_width;
+    m_stats.height = m_height;
+
+    m_triangles.clear();
+    std::ranges::for_each(m_bins, [](auto& bin) { bin.clear(); });
+    std::ranges::fill(m_tile_stats, TileStats{});
     
-    std::ranges::for_each(faces, [&](const Face& face) {
-        if (mtl_count == mtls[mtl_index]){
-            mtl_index++;
-            m_raster.next_texture();
-            mtl_count = 0;
-        }
-        
+    // Materials past the table reuse it from the start
+    const int materials_count = m_raster.get_materials_count();
+    for (size_t i = 0; i < faces.size(); ++i) {
+        const Face& face = faces[i];
+        const int material = static_cast<int>(material_ids[i] % materials_count);
+
         const auto& p1 = vertices[face[0][0]];
         const auto& p2 = vertices[face[1][0]];
         const auto& p3 = vertices[face[2][0]];
-        const auto& s1 = screen_vertices[face[0][0]];
-        const auto& s2 = screen_vertices[face[1][0]];
-        const auto& s3 = screen_vertices[face[2][0]];
+        const auto& s1 = m_screen_vertices[face[0][0]];
+        const auto& s2 = m_screen_vertices[face[1][0]];
+        const auto& s3 = m_screen_vertices[face[2][0]];
         const auto& t1 = texture_vertices[face[0][1]];
         const auto& t2 = texture_vertices[face[1][1]];
         const auto& t3 = texture_vertices[face[2][1]];
@@ -196,16 +992,56 @@ void Renderer::draw(const Vertices& vertices, const Faces& faces,
         const auto& n2 = normals[face[1][2]];
         const auto& n3 = normals[face[2][2]];
 
-        if (check_vertex(s1) && check_vertex(s2) && check_vertex(s3)) {
-            PointData p41{p1, s1, n1, t1};
-            PointData p42{p2, s2, n2, t2};
-            PointData p43{p3, s3, n3, t3};
-        
-            draw_triangle(p41, p42, p43);
+        const uint8_t c1 = m_clip_codes[face[0][0]];
+        const uint8_t c2 = m_clip_codes[face[1][0]];
+        const uint8_t c3 = m_clip_codes[face[2][0]];
+
+        if ((c1 & c2 & c3) != 0) {
+            m_stats.culled_frustum++;
+        } else if ((c1 | c2 | c3) == 0) {
+            submit_triangle(Triangle{
+                {p1, s1, n1, t1},
+                {p2, s2, n2, t2},
+                {p3, s3, n3, t3},
+                material
+            });
+        } else {
+            clip_triangle(ClippedPolygon{{
+                {p1, m_clip_vertices[face[0][0]], n1, t1},
+                {p2, m_clip_vertices[face[1][0]], n2, t2},
+                {p3, m_clip_vertices[face[2][0]], n3, t3}
+            }}, material, c1 | c2 | c3);
+        }
+    }
+
+    m_stats.transform_time = get_elapsed_ms(draw_start);
+
+    const auto tiles_start = Clock::now();
+    std::vector<std::future<std::any>> futures{};
+    for (int i = 0; i < m_tiles_x * m_tiles_y; ++i) {
+        if (!m_bins[i].empty()) {
+            futures.emplace_back(m_pool.add_task([this, i] { draw_tile(i); }));
         }
-        
-        mtl_count++;
+    }
+
+    std::ranges::for_each(futures, [](auto& current_future){
+        current_future.get();
     });
+
+    std::ranges::for_each(m_tile_stats, [&](const TileStats& tile_stats) {
+        m_stats.hiz_tested_blocks += tile_stats.hiz_tested_blocks;
+        m_stats.hiz_rejected_blocks += tile_stats.hiz_rejected_blocks;
+        m_stats.hiz_rejected_triangles += tile_stats.hiz_rejected_triangles;
+        m_stats.cleared_blocks += tile_stats.cleared_blocks;
+        m_stats.raster_time += tile_stats.raster_time;
+        m_stats.shade_time += tile_stats.shade_time;
+    });
+    m_stats.tiles_time = get_elapsed_ms(tiles_start);
+
+    const auto resolve_start = Clock::now();
+    resolve_blocks();
+    m_stats.resolve_time = get_elapsed_ms(resolve_start);
+    m_stats.draw_time = get_elapsed_ms(draw_start);
 }
 
 glm::mat4x4 Renderer::get_view_matrix() const {
@@ -227,8 +1063,9 @@ glm::mat4x4 Renderer::get_view_matrix() const {
 
 glm::mat4x4 Renderer::get_projection_matrix() const {
     constexpr float f = 1.0 / std::tan(FOV * 0.5);
+    const float aspect = static_cast<float>(m_width) / m_height;
     return glm::mat4x4{
-        {f / ASPECT, 0,  0,  0},
+        {f / aspect, 0,  0,  0},
         {0, f,  0,  0},
         {0, 0, ZFAR / (ZNEAR - ZFAR), ZFAR * ZNEAR / (ZNEAR - ZFAR)},
         {0, 0, -1,  0}
@@ -237,8 +1074,8 @@ glm::mat4x4 Renderer::get_projection_matrix() const {
 
 glm::mat4x4 Renderer::get_viewport_matrix() const {
     return glm::mat4x4{
-        {WIDTH / 2, 0, 0, WIDTH / 2},
-        {0, -HEIGHT / 2, 0, HEIGHT / 2},
+        {m_width / 2.0f, 0, 0, m_width / 2.0f},
+        {0, -m_height / 2.0f, 0, m_height / 2.0f},
         {0, 0, 1, 0},
         {0, 0, 0, 1}
     };
@@ -254,24 +1091,18 @@ glm::mat4x4 Renderer::get_scale_matrix() const {
     }; 
 }
 
-ScreenVertices Renderer::get_screen_vertices(const Vertices& vertices) const {
+ScreenVertices Renderer::get_clip_vertices(const Vertices& vertices) const {
     const auto view_matrix = get_view_matrix();
     const auto viewport_matrix = get_viewport_matrix();
     const auto scale_matrix = get_scale_matrix();
     const auto projection_matrix = get_projection_matrix();
     const auto cached_matrix = glm::transpose(view_matrix * projection_matrix * viewport_matrix);
 
-    ScreenVertices screen_vertices;
-    std::ranges::transform(vertices, std::back_inserter(screen_vertices), [&](const auto& vertex) {
+    ScreenVertices clip_vertices;
+    std::ranges::transform(vertices, std::back_inserter(clip_vertices), [&](const auto& vertex) {
         glm::vec4 world = {vertex, 1.0f};
-        glm::vec4 screen = cached_matrix * world;
-        if (screen.w != 0) {
-            screen.x /= screen.w;
-            screen.y /= screen.w;
-            screen.z /= screen.w;
-        }
-        return screen;
+        return cached_matrix * world;
     });
 
-    return screen_vertices;
+    return clip_vertices;
 }
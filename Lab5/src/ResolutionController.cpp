@@ -0,0 +1,84 @@
+#include "ResolutionController.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float MIN_SCALE{0.5f};
+constexpr float MAX_SCALE{1.0f};
+
+// Weight of the newest frame in the moving average of the frame time
+constexpr float SMOOTHING{0.1f};
+
+// The resolution is lowered above the target and raised only with enough headroom,
+// the gap between the two keeps it from oscillating around the target
+constexpr float DOWNSCALE_THRESHOLD{1.0f};
+constexpr float UPSCALE_THRESHOLD{0.8f};
+
+// Limits of a single step, dropping is allowed to be faster than climbing back
+constexpr float MAX_DOWNSCALE_STEP{0.85f};
+constexpr float MAX_UPSCALE_STEP{1.05f};
+
+// Frames to wait after a change, so the average reflects the new resolution
+constexpr int COOLDOWN_FRAMES{15};
+
+// Widths are kept a multiple of the 8 pixel rasterizer block to keep spans full
+constexpr int WIDTH_ALIGNMENT{8};
+
+}
+
+ResolutionController::ResolutionController(int max_width, int max_height, float target_fps) noexcept
+    : m_max_width(max_width)
+    , m_max_height(max_height)
+    , m_target_frame_time(1.0f / target_fps)
+    , m_average_frame_time(1.0f / target_fps)
+{}
+
+void ResolutionController::update(float frame_time) {
+    m_average_frame_time = std::lerp(m_average_frame_time, frame_time, SMOOTHING);
+
+    if (!m_enabled || m_cooldown > 0) {
+        m_cooldown = std::max(m_cooldown - 1, 0);
+        return;
+    }
+
+    const float load = m_average_frame_time / m_target_frame_time;
+    if (load <= DOWNSCALE_THRESHOLD && load >= UPSCALE_THRESHOLD) return;
+
+    // Raster and shading cost is proportional to the pixel count, that is to the scale squared
+    const float step = std::clamp(1.0f / std::sqrt(load), MAX_DOWNSCALE_STEP, MAX_UPSCALE_STEP);
+    const float scale = std::clamp(m_scale * step, MIN_SCALE, MAX_SCALE);
+
+    if (scale != m_scale) {
+        m_scale = scale;
+        m_cooldown = COOLDOWN_FRAMES;
+    }
+}
+
+void ResolutionController::set_enabled(bool enabled) {
+    m_enabled = enabled;
+    if (!enabled) {
+        m_scale = MAX_SCALE;
+    }
+    m_average_frame_time = m_target_frame_time;
+    m_cooldown = COOLDOWN_FRAMES;
+}
+
+bool ResolutionController::get_enabled() const {
+    return m_enabled;
+}
+
+int ResolutionController::get_width() const {
+    const int width = static_cast<int>(m_max_width * m_scale) / WIDTH_ALIGNMENT * WIDTH_ALIGNMENT;
+    return std::clamp(width, WIDTH_ALIGNMENT, m_max_width);
+}
+
+int ResolutionController::get_height() const {
+    // Derived from the width, so the aspect ratio survives the alignment of the width
+    const int height = static_cast<int>(std::lround(get_width() * static_cast<float>(m_max_height) / m_max_width));
+    return std::clamp(height, 1, m_max_height);
+}
+
+float ResolutionController::get_scale() const {
+    return m_scale;
+}
@@ -5,6 +5,7 @@
 
 #include "Scene.hpp"
 #include "Color.hpp"
+#include "ThreadPool.hpp"
 
 using namespace std::string_literals;
 
@@ -16,31 +17,93 @@ constexpr int FPS = 60;
 
 }
 
-bool Scene::initialize() {
-    auto parser = Parser::create_parser("obj");
-    if (!parser) {
+Scene::Scene() noexcept
+    : m_loader(std::max(1, static_cast<int>(std::thread::hardware_concurrency())))
+{
+}
+
+Scene::~Scene() {
+    m_cancelled = true;
+}
+
+bool Scene::initialize(const ProgressCallback& on_progress) {
+    if (!Parser::create_parser("obj")) {
         return false;
     }
 
+    // With room for all the frames, references to loaded ones stay valid as others arrive
+    m_models.clear();
+    m_models.reserve(FRAMES_COUNT);
+    m_paths.clear();
+    m_pending.clear();
+    m_on_progress = on_progress;
+    m_cancelled = false;
+    m_index = 0;
+
+    // Frames do not depend on each other, each task parses one with a parser of its own. 
+    // The pool takes tasks in order, so the first frame is loaded first
     for (int i = 0; i < FRAMES_COUNT; ++i) {
         char frame_str[5];
         std::snprintf(frame_str, sizeof(frame_str), "%04d", i);
-        std::string path = std::string(MODEL_FILE_PATH_PREFIX) + frame_str + ".obj";
+        m_paths.push_back(std::string(MODEL_FILE_PATH_PREFIX) + frame_str + ".obj");
+
+        m_pending.push_back(m_loader.add_task([this, path = m_paths.back()] {
+            if (m_cancelled) {
+                return Model{};
+            }
+            auto parser = Parser::create_parser("obj");
+            parser->parse_file(path);
+
+            Model model;
+            model.m_faces = std::move(*parser).get_faces();
+            model.m_normals = std::move(*parser).get_normals();
+            model.m_texture_vertices = std::move(*parser).get_texture_vertices();
+            model.m_vertices = std::move(*parser).get_vertices();
+            model.m_material_ids = std::move(*parser).get_material_ids();
+            return model;
+        }));
+    }
 
-        parser->parse_file(path);
+    // Nothing can be drawn without the first frame, a missing file leaves it empty as well
+    m_pending.front().wait();
+    update_frames();
+    if (m_models.front().m_faces.empty()) {
+        std::cerr << "Failed to load the first frame: " << m_paths.front() << std::endl;
+        m_cancelled = true;
+        return false;
+    }
+    return true;
+}
 
-        Model current;
-        current.m_faces = parser->get_faces();
-        current.m_normals = parser->get_normals();
-        current.m_texture_vertices = parser->get_texture_vertices();
-        current.m_vertices = parser->get_vertices();
-        current.m_mtls = parser->get_mtls();
+void Scene::wait_for_frames() {
+    std::ranges::for_each(m_pending, [](const auto& result) { 
+        if (result.valid()) {
+            result.wait(); 
+        }
+    });
+    update_frames();
+}
 
-        m_models.emplace_back(std::move(current));
-        std::cout << "Loaded: " << path << '\n';
+// A frame that fails to load is left empty, so the ones after it still play
+void Scene::update_frames() {
+    while (m_models.size() < m_pending.size()) {
+        auto& result = m_pending[m_models.size()];
+        if (result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return;
+        }
+
+        const std::string& path = m_paths[m_models.size()];
+        try {
+            m_models.push_back(std::any_cast<Model>(result.get()));
+            std::cout << "Loaded: " << path << '\n';
+        } catch (const std::exception& e) {
+            m_models.emplace_back();
+            std::cerr << "Frame loading error: " << path << ": " << e.what() << std::endl;
+        }
+        if (m_on_progress) {
+            m_on_progress(static_cast<int>(m_models.size()), FRAMES_COUNT);
+        }
     }
-
-    return true;
 }
 
 void Scene::rotate_model(const glm::vec3& rotate_vector) {
@@ -56,12 +119,23 @@ void Scene::update() {
     
     m_elapsed_time += m_clock.restart();
     
+    update_frames();
+    const int ready_frames = static_cast<int>(m_models.size());
     while (m_elapsed_time.asSeconds() >= seconds_per_frame) {
-        m_index = (m_index + 1) % FRAMES_COUNT;
+        const int next = (m_index + 1) % FRAMES_COUNT;
+        if (next < ready_frames) {
+            m_index = next;
+        }
         m_elapsed_time -= sf::seconds(seconds_per_frame);
     }
 }
 
+// Selects an animation frame directly, for runs that must not depend on the wall clock. 
+// Frames that are not loaded yet are replaced by the last loaded one
+void Scene::set_frame(int frame) {
+    m_index = std::min(frame % FRAMES_COUNT, static_cast<int>(m_models.size()) - 1);
+}
+
 Vertices Scene::get_vertices() const {
     auto move_matrix = create_move_matrix(m_model_position);
     auto rotation_matrix = create_rotation_matrix(m_model_rotation);
@@ -96,6 +170,6 @@ const TextureVertices& Scene::get_texture_vertices() const {
     return m_models[m_index].m_texture_vertices;
 }
 
-const Mtls& Scene::get_mtls() const {
-    return m_models[m_index].m_mtls;
+const MaterialIds& Scene::get_material_ids() const {
+    return m_models[m_index].m_material_ids;
 }
@@ -0,0 +1,65 @@
+#include "Simd.hpp"
+
+#if defined(_MSC_VER) && defined(AKG_SIMD_X86)
+#include <intrin.h>
+#endif
+
+namespace {
+
+#if defined(_MSC_VER) && defined(AKG_SIMD_X86)
+
+bool detect_avx2() {
+    int info[4]{};
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    const bool fma = (info[2] & (1 << 12)) != 0;
+    if (!osxsave || !avx || !fma) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+}
+
+bool detect_sse41() {
+    int info[4]{};
+    __cpuid(info, 1);
+    return (info[2] & (1 << 19)) != 0;
+}
+
+#elif defined(AKG_SIMD_X86)
+
+bool detect_avx2() {
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+bool detect_sse41() {
+    return __builtin_cpu_supports("sse4.1");
+}
+
+#else
+
+bool detect_avx2() {
+    return false;
+}
+
+bool detect_sse41() {
+    return false;
+}
+
+#endif
+
+}
+
+bool Simd::has_avx2() {
+    static const bool result = detect_avx2();
+    return result;
+}
+
+bool Simd::has_sse41() {
+    static const bool result = detect_sse41();
+    return result;
+}
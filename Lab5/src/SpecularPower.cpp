@@ -0,0 +1,185 @@
+#include "SpecularPower.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int MIN_TABLE_SIZE{2};
+constexpr int MAX_TABLE_SIZE{1 << 16};
+constexpr float MIN_ERROR{1e-7f};
+
+}
+
+SpecularPower::SpecularPower(float exponent, float max_error) noexcept
+    : m_exponent(exponent)
+    , m_max_error(std::max(max_error, MIN_ERROR))
+{
+    // Below the cutoff x^exponent is under max_error, so it is treated as zero
+    m_cutoff = std::pow(m_max_error, 1.0f / exponent);
+
+    // Linear interpolation between samples h apart is off by at most h^2 / 8 * max|f''|, 
+    // half of the error budget is left for the rounding of the samples themselves
+    const double a = exponent;
+    const double max_second_derivative = a * std::abs(a - 1) * std::max(std::pow(m_cutoff, a - 2), 1.0);
+    const double step = max_second_derivative > 0 
+        ? std::sqrt(4.0 * m_max_error / max_second_derivative) 
+        : 1.0;
+
+    const int size = static_cast<int>(std::ceil((1.0 - m_cutoff) / step)) + 1;
+    m_table.resize(std::clamp(size, MIN_TABLE_SIZE, MAX_TABLE_SIZE));
+    m_inv_step = (m_table.size() - 1) / (1.0f - m_cutoff);
+
+    for (int i = 0; i < static_cast<int>(m_table.size()); ++i) {
+        const double x = m_cutoff + (1.0 - m_cutoff) * i / (m_table.size() - 1);
+        m_table[i] = static_cast<float>(std::pow(x, a));
+    }
+
+    const float integer_part = std::round(exponent);
+    m_integer_exponent = integer_part == exponent && exponent >= 0 ? static_cast<int>(integer_part) : -1;
+}
+
+float SpecularPower::evaluate(float x, Mode mode) const {
+    switch (mode) {
+        case Mode::Table: return table(x);
+        case Mode::Squaring: return squaring(x);
+        default: return exact(x);
+    }
+}
+
+float SpecularPower::exact(float x) const {
+    return std::pow(x, m_exponent);
+}
+
+float SpecularPower::table(float x) const {
+    if (x <= m_cutoff) return 0.0f;
+    if (x >= 1.0f) return 1.0f;
+
+    const float position = (x - m_cutoff) * m_inv_step;
+    const int index = std::min(static_cast<int>(position), static_cast<int>(m_table.size()) - 2);
+    const float t = position - index;
+    return m_table[index] + (m_table[index + 1] - m_table[index]) * t;
+}
+
+// Exponentiation by squaring, not an approximation: the power of an integer exponent up to 
+// rounding in a handful of multiplications for the usual shininess values. Exponents that 
+// are not integer go through the table instead
+float SpecularPower::squaring(float x) const {
+    if (m_integer_exponent < 0) return table(x);
+    if (x <= m_cutoff) return 0.0f;
+
+    float result = 1.0f;
+    float base = x;
+    for (int exponent = m_integer_exponent; exponent != 0; exponent >>= 1) {
+        if (exponent & 1) {
+            result *= base;
+        }
+        base *= base;
+    }
+    return result;
+}
+
+float SpecularPower::get_exponent() const {
+    return m_exponent;
+}
+
+float SpecularPower::get_max_error() const {
+    return m_max_error;
+}
+
+int SpecularPower::get_table_size() const {
+    return static_cast<int>(m_table.size());
+}
+
+#ifdef AKG_SIMD_X86
+
+// Table lookups clamp x to the table range first, lanes outside it are replaced afterwards
+AKG_TARGET_AVX2
+__m256 SpecularPower::evaluate_avx2(__m256 x, Mode mode) const {
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 cutoff = _mm256_set1_ps(m_cutoff);
+
+    if (mode == Mode::Exact) {
+        alignas(32) float values[8];
+        _mm256_store_ps(values, x);
+        for (float& value : values) {
+            value = exact(value);
+        }
+        return _mm256_load_ps(values);
+    }
+
+    if (mode == Mode::Squaring && m_integer_exponent >= 0) {
+        // Lanes under the cutoff are zeroed below, raising them would go through denormals
+        __m256 result = one;
+        __m256 base = _mm256_max_ps(x, cutoff);
+        for (int exponent = m_integer_exponent; exponent != 0; exponent >>= 1) {
+            if (exponent & 1) {
+                result = _mm256_mul_ps(result, base);
+            }
+            base = _mm256_mul_ps(base, base);
+        }
+        return _mm256_blendv_ps(result, zero, _mm256_cmp_ps(x, cutoff, _CMP_LE_OQ));
+    }
+
+    const __m256 position = _mm256_mul_ps(
+        _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(x, cutoff), one), cutoff), _mm256_set1_ps(m_inv_step));
+    const __m256i index = _mm256_min_epi32(
+        _mm256_cvttps_epi32(position), _mm256_set1_epi32(static_cast<int>(m_table.size()) - 2));
+    const __m256 t = _mm256_sub_ps(position, _mm256_cvtepi32_ps(index));
+    const __m256 low = _mm256_i32gather_ps(m_table.data(), index, 4);
+    const __m256 high = _mm256_i32gather_ps(m_table.data() + 1, index, 4);
+    const __m256 result = _mm256_add_ps(low, _mm256_mul_ps(_mm256_sub_ps(high, low), t));
+
+    return _mm256_blendv_ps(_mm256_blendv_ps(result, one, _mm256_cmp_ps(x, one, _CMP_GE_OQ)), 
+                            zero, _mm256_cmp_ps(x, cutoff, _CMP_LE_OQ));
+}
+
+AKG_TARGET_SSE41
+__m128 SpecularPower::evaluate_sse41(__m128 x, Mode mode) const {
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 cutoff = _mm_set1_ps(m_cutoff);
+
+    if (mode == Mode::Exact) {
+        alignas(16) float values[4];
+        _mm_store_ps(values, x);
+        for (float& value : values) {
+            value = exact(value);
+        }
+        return _mm_load_ps(values);
+    }
+
+    if (mode == Mode::Squaring && m_integer_exponent >= 0) {
+        __m128 result = one;
+        __m128 base = _mm_max_ps(x, cutoff);
+        for (int exponent = m_integer_exponent; exponent != 0; exponent >>= 1) {
+            if (exponent & 1) {
+                result = _mm_mul_ps(result, base);
+            }
+            base = _mm_mul_ps(base, base);
+        }
+        return _mm_blendv_ps(result, zero, _mm_cmple_ps(x, cutoff));
+    }
+
+    // Without a gather the table entries are read lane by lane
+    const __m128 position = _mm_mul_ps(
+        _mm_sub_ps(_mm_min_ps(_mm_max_ps(x, cutoff), one), cutoff), _mm_set1_ps(m_inv_step));
+    const __m128i index = _mm_min_epi32(
+        _mm_cvttps_epi32(position), _mm_set1_epi32(static_cast<int>(m_table.size()) - 2));
+    const __m128 t = _mm_sub_ps(position, _mm_cvtepi32_ps(index));
+
+    alignas(16) int32_t indices[4];
+    alignas(16) float low_values[4];
+    alignas(16) float high_values[4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(indices), index);
+    for (int lane = 0; lane < 4; ++lane) {
+        low_values[lane] = m_table[indices[lane]];
+        high_values[lane] = m_table[indices[lane] + 1];
+    }
+    const __m128 low = _mm_load_ps(low_values);
+    const __m128 result = _mm_add_ps(low, _mm_mul_ps(_mm_sub_ps(_mm_load_ps(high_values), low), t));
+
+    return _mm_blendv_ps(_mm_blendv_ps(result, one, _mm_cmpge_ps(x, one)), zero, _mm_cmple_ps(x, cutoff));
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include "Texture2D.hpp"
+#include <algorithm>
+#include <bit>
+#include <new>
+#include <stdexcept>
+
+namespace {
+
+constexpr int MAX_MORTON_SIZE{1 << 16};
+
+// Inserts a zero bit above each of the 16 lower bits
+size_t spread_bits(int value) {
+    size_t bits = static_cast<uint32_t>(value) & 0xFFFF;
+    bits = (bits | (bits << 8)) & 0x00FF00FF;
+    bits = (bits | (bits << 4)) & 0x0F0F0F0F;
+    bits = (bits | (bits << 2)) & 0x33333333;
+    bits = (bits | (bits << 1)) & 0x55555555;
+    return bits;
+}
+
+}
+
+Texture2D::Texture2D(int width, int height, Layout layout, uint32_t fill) {
+    set_layout(width, height, layout);
+    m_storage.reset(static_cast<uint32_t*>(
+        ::operator new[](m_size * sizeof(uint32_t), std::align_val_t{ALIGNMENT})));
+    std::fill_n(m_storage.get(), m_size, fill);
+    m_data = m_storage.get();
+}
+
+Texture2D Texture2D::view(int width, int height, Layout layout, const uint32_t* texels) {
+    Texture2D texture;
+    texture.set_layout(width, height, layout);
+    texture.m_data = texels;
+    return texture;
+}
+
+size_t Texture2D::get_size(int width, int height, Layout layout) {
+    if (width <= 0 || height <= 0) {
+        throw std::invalid_argument("Texture size must be positive");
+    }
+    if (layout == Layout::Linear) {
+        return static_cast<size_t>(width) * height;
+    }
+
+    // Z-order covers a power of two square, a rectangle leaves the unused part empty
+    const int side = static_cast<int>(std::bit_ceil(static_cast<unsigned>(std::max(width, height))));
+    if (side > MAX_MORTON_SIZE) {
+        throw std::invalid_argument("Texture is too large for the Morton layout");
+    }
+    return static_cast<size_t>(side) * side;
+}
+
+void Texture2D::set_layout(int width, int height, Layout layout) {
+    m_size = get_size(width, height, layout);
+    m_width = width;
+    m_height = height;
+    m_layout = layout;
+    m_offsets_x.resize(width);
+    m_offsets_y.resize(height);
+
+    if (layout == Layout::Morton) {
+        for (int x = 0; x < width; ++x) m_offsets_x[x] = spread_bits(x);
+        for (int y = 0; y < height; ++y) m_offsets_y[y] = spread_bits(y) << 1;
+    } else {
+        for (int x = 0; x < width; ++x) m_offsets_x[x] = x;
+        for (int y = 0; y < height; ++y) m_offsets_y[y] = static_cast<size_t>(y) * width;
+    }
+}
+
+void Texture2D::Deleter::operator()(uint32_t* data) const {
+    ::operator delete[](data, std::align_val_t{ALIGNMENT});
+}
+
+Texture2D::Layout Texture2D::get_layout() const {
+    return m_layout;
+}
+
+size_t Texture2D::size() const {
+    return m_size;
+}
+
+const uint32_t* Texture2D::data() const {
+    return m_data;
+}
+
+uint32_t* Texture2D::data() {
+    return m_storage.get();
+}
@@ -1,7 +1,49 @@
 #include "MainForm.hpp"
+#include "HeadlessRunner.hpp"
+#include <iostream>
+#include <string_view>
+#include <charconv>
 
-int main() {
-    MainForm form;
+namespace {
+
+constexpr auto DEFAULT_REPORT_PATH = "benchmark.json";
+
+void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--compress-textures] [--headless <frames> [--output <report.json>]]\n";
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    int headless_frames = 0;
+    std::string output_path = DEFAULT_REPORT_PATH;
+    bool texture_compression = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--headless" && i + 1 < argc) {
+            const std::string_view value = argv[++i];
+            const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), headless_frames);
+            if (error != std::errc{} || end != value.data() + value.size() || headless_frames <= 0) {
+                print_usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            output_path = argv[++i];
+        } else if (arg == "--compress-textures") {
+            texture_compression = true;
+        } else {
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (headless_frames > 0) {
+        HeadlessRunner runner(headless_frames, output_path, texture_compression);
+        return runner.run() ? 0 : 1;
+    }
+
+    MainForm form(texture_compression);
     form.run_main_loop();
     return 0;
-}
\ No newline at end of file
+}